@@ -0,0 +1,10 @@
+@ Every load here is right before its pool, so it reaches its constant with
+@ a negative offset. The constants have the eq condition and the flags are
+@ ne, so the pool words are skipped instead of run (-O assumes execution
+@ never runs into a pool, so this program is not meant for it).
+@ Ends with r0 = 0x01234567 and r1 = 0x089abcde
+mov r2, #1
+cmp r2, #0
+ldr r0, =0x01234567
+.ltorg
+ldr r1, =0x089abcde
@@ -18,21 +18,45 @@ char *copy(const char *original) {
   return res;
 }
 
+void *allocate(arena *pool, size_t size) {
+  if (pool) {
+    return arenaAlloc(pool, size);
+  }
+
+  void *res = malloc(size);
+
+  if (!res) {
+    // malloc has failed exit
+    fprintf(stderr, "The malloc from the allocate function has failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  return res;
+}
+
 // ---------------------------MAP---------------------------------
 void clearMap(map *m) {
-  mapNode *ptr = m->head;
+  mapNode *ptr = m->pool ? NULL : m->head;
   while(ptr) {
     mapNode *prev = ptr;
     ptr = ptr->next;
     free(prev->key);
     free(prev);
   }
+  free(m->buckets);
   m->head = NULL;
+  m->tail = NULL;
   m->size = 0;
+  m->buckets = NULL;
+  m->capacity = 0;
 }
 
 map constructMap(void) {
-  map m = {NULL, 0};
+  return constructMapInArena(NULL);
+}
+
+map constructMapInArena(arena *pool) {
+  map m = {NULL, NULL, 0, pool, NULL, 0};
   return m;
 }
 
@@ -42,10 +66,38 @@ uint32_t *get(map m, char *key) {
   return lookup(m, key, &ptr) ? &(ptr->value) : NULL;
 }
 
+uint32_t *getSlice(map m, const char *key, int length) {
+  mapNode *ptr = NULL;
+
+  return lookupSlice(m, key, length, &ptr) ? &(ptr->value) : NULL;
+}
+
 bool isEmptyMap(map m) {
   return !m.size;
 }
 
+static void indexNode(map *m, mapNode *node) {
+  uint32_t bucket = hashSlice(node->key, strlen(node->key)) &
+                    (m->capacity - 1);
+  node->chain = m->buckets[bucket];
+  m->buckets[bucket] = node;
+}
+
+static void rehash(map *m) {
+  free(m->buckets);
+  m->capacity = m->capacity ? 2 * m->capacity : MAP_MIN_CAPACITY;
+  m->buckets = calloc(m->capacity, sizeof(mapNode *));
+
+  if (!m->buckets) {
+    fprintf(stderr, "The calloc from the rehash function has failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (mapNode *ptr = m->head; ptr; ptr = ptr->next) {
+    indexNode(m, ptr);
+  }
+}
+
 void put(map *m, char *key, uint32_t value) {
   mapNode *ptr = NULL;
   if(lookup(*m, key, &ptr)) {
@@ -53,9 +105,10 @@ void put(map *m, char *key, uint32_t value) {
     ptr->value = value;
   } else {
     // if not found
-    mapNode *pNewNode = malloc(sizeof(mapNode));
+    mapNode *pNewNode = allocate(m->pool, sizeof(mapNode));
     pNewNode->next    = NULL;
-    pNewNode->key     = copy(key);
+    pNewNode->key     = m->pool ? arenaCopy(m->pool, key, strlen(key))
+                                : copy(key);
     pNewNode->value   = value;
     if (!ptr) {
       // no elemnts in mapping
@@ -64,19 +117,47 @@ void put(map *m, char *key, uint32_t value) {
       // make last element point to newNode
       ptr->next = pNewNode;
     }
+    m->tail = pNewNode;
     m->size++;
+
+    if (m->size > m->capacity) {
+      // keep at most one node per bucket on average
+      rehash(m);
+    } else {
+      indexNode(m, pNewNode);
+    }
+  }
+}
+
+uint32_t hashSlice(const char *key, int length) {
+  uint32_t hash = 2166136261u;
+
+  for (int i = 0; i < length; i++) {
+    hash ^= (unsigned char) key[i];
+    hash *= 16777619u;
   }
+
+  return hash;
 }
 
 bool lookup(map m, char *key, mapNode **ptr) {
-  *ptr = m.head;
-  while (m.head) {
-    *ptr = m.head;
-    if (!strcmp(m.head->key, key)) {
+  return lookupSlice(m, key, strlen(key), ptr);
+}
+
+bool lookupSlice(map m, const char *key, int length, mapNode **ptr) {
+  *ptr = m.tail;
+  if (!m.buckets) {
+    return false;
+  }
+
+  mapNode *node = m.buckets[hashSlice(key, length) & (m.capacity - 1)];
+  while (node) {
+    if (!strncmp(node->key, key, length) && node->key[length] == '\0') {
       // if keys match
+      *ptr = node;
       return true;
     }
-    m.head = m.head->next;
+    node = node->chain;
   }
   return false;
 }
@@ -95,21 +176,34 @@ void printMap(map m) {
 // --------------------------VECTOR--------------------------------
 void clearVector(vector *v) {
   while (!isEmptyVector(*v)) {
-    free(getFront(v));
+    char *value = getFront(v);
+    if (!v->pool) {
+      free(value);
+    }
   }
   v->size = 0;
 }
 
 vector constructVector(void) {
-  vector v = {NULL, NULL, 0};
+  return constructVectorInArena(NULL);
+}
+
+vector constructVectorInArena(arena *pool) {
+  vector v = {NULL, NULL, 0, pool};
   return v;
 }
 
-void putFront(vector *v, char *value) {
-  vectorNode *pNv = malloc(sizeof(vectorNode));
+static vectorNode *constructVectorNode(vector *v, char *value) {
+  vectorNode *pNv = allocate(v->pool, sizeof(vectorNode));
   pNv->previous = NULL;
-  pNv->value = copy(value);
+  pNv->value = v->pool ? arenaCopy(v->pool, value, strlen(value))
+                       : copy(value);
   pNv->next = NULL;
+  return pNv;
+}
+
+void putFront(vector *v, char *value) {
+  vectorNode *pNv = constructVectorNode(v, value);
 
   if (isEmptyVector(*v)) {
     v->first = pNv;
@@ -123,10 +217,7 @@ void putFront(vector *v, char *value) {
 }
 
 void putBack(vector *v, char *value) {
-  vectorNode *pNv = malloc(sizeof(vectorNode));
-  pNv->previous = NULL;
-  pNv->value = copy(value);
-  pNv->next = NULL;
+  vectorNode *pNv = constructVectorNode(v, value);
 
   if (isEmptyVector(*v)) {
     v->first = pNv;
@@ -170,7 +261,9 @@ char *getFront(vector *v) {
   } else {
     v->last = NULL;
   }
-  free(removedNode);
+  if (!v->pool) {
+    free(removedNode);
+  }
   (v->size)--;
 
   return ret;
@@ -190,7 +283,9 @@ char *getBack(vector *v) {
   } else {
     v->first = NULL;
   }
-  free(removedNode);
+  if (!v->pool) {
+    free(removedNode);
+  }
   (v->size)--;
 
   return ret;
@@ -224,3 +319,33 @@ bool contains(vector v, char *value) {
 
   return false;
 }
+
+// --------------------------ARRAY---------------------------------
+array constructArray(void) {
+  array a = {NULL, 0, 0};
+  return a;
+}
+
+void clearArray(array *a) {
+  free(a->values);
+  a->values   = NULL;
+  a->size     = 0;
+  a->capacity = 0;
+}
+
+void append(array *a, uint32_t value) {
+  if (a->size == a->capacity) {
+    int capacity = a->capacity ? 2 * a->capacity : 16;
+    uint32_t *values = realloc(a->values, capacity * sizeof(uint32_t));
+
+    if (!values) {
+      fprintf(stderr, "The realloc from the append function has failed\n");
+      exit(EXIT_FAILURE);
+    }
+
+    a->values   = values;
+    a->capacity = capacity;
+  }
+
+  a->values[a->size++] = value;
+}
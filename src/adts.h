@@ -1,22 +1,35 @@
 #ifndef ADTS_H
 #define ADTS_H
 
-#include "headers.h"
+#include "arena.h"
+
+// ---------------------------MACROS-----------------------------
+#define MAP_MIN_CAPACITY 16
 
 // -------------------------TYPES---------------------------------
 typedef struct map map;
 typedef struct mapNode mapNode;
 typedef struct vector vector;
 typedef struct vectorNode vectorNode;
+typedef struct array array;
 
 // -------------------------STRUCTS-------------------------------
+/**
+* The nodes are kept in insertion order in the list starting at head and
+* are indexed by a hash table of capacity buckets chained through chain
+**/
 struct map {
   mapNode *head;
+  mapNode *tail;
   int     size;
+  arena   *pool;
+  mapNode **buckets;
+  int     capacity;
 };
 
 struct mapNode {
   mapNode    *next;
+  mapNode    *chain;
   char       *key;
   uint32_t   value;
 };
@@ -31,6 +44,13 @@ struct vector {
   vectorNode *first;
   vectorNode *last;
   int size;
+  arena *pool;
+};
+
+struct array {
+  uint32_t *values;
+  int      size;
+  int      capacity;
 };
 
 // -------------------FUNCTION DECLARATIONS-----------------------
@@ -38,10 +58,22 @@ struct vector {
 /* returns a copy on the heap of the original string */
 char *copy(const char *original);
 
+/**
+* Returns size bytes from the pool or from malloc if there is no pool
+* Exits if there is no memory left
+**/
+void *allocate(arena *pool, size_t size);
+
 // ---------------------------MAP---------------------------------
 /* Constructor function that will retrun an empty map */
 map constructMap(void);
 
+/**
+* Constructor function that will return an empty map whose nodes and keys
+* are owned by the pool (they are released with the pool, not by clearMap)
+**/
+map constructMapInArena(arena *pool);
+
 /* Clears the map and frees all elements*/
 void clearMap(map *m);
 
@@ -54,12 +86,21 @@ bool isEmptyMap(map m);
 **/
 uint32_t *get(map m, char *key);
 
+/**
+* Same as get but the key is the slice of length characters starting at key
+* which doesn't need to be null terminated
+**/
+uint32_t *getSlice(map m, const char *key, int length);
+
 /**
 * If the key is found the value is modified to the value parameter
 * If the key is not found the pair (key, value) is added to the table
 **/
 void put(map *m, char *key, uint32_t value);
 
+/* Returns the FNV-1a hash of the slice of length characters at key */
+uint32_t hashSlice(const char *key, int length);
+
 /**
 * Helper function
 * Takes 3 parameters: pointer to table, a key, a pointer which will be
@@ -70,6 +111,9 @@ void put(map *m, char *key, uint32_t value);
 **/
 bool lookup(map m, char *key, mapNode **ptr);
 
+/* Same as lookup but the key is a slice of length characters */
+bool lookupSlice(map m, const char *key, int length, mapNode **ptr);
+
 /* Prints map */
 void printMap(map m);
 
@@ -77,6 +121,13 @@ void printMap(map m);
 /* Constructor function that will retrun an empty vector */
 vector constructVector(void);
 
+/**
+* Constructor function that will return an empty vector whose nodes and
+* values are owned by the pool. Values returned by getFront/getBack must not
+* be freed
+**/
+vector constructVectorInArena(arena *pool);
+
 /* Clears the vector and frees all elements*/
 void clearVector(vector *v);
 
@@ -119,4 +170,14 @@ void printVector(vector v);
 /* Returns true iff the element is in the vector */
 bool contains(vector v, char *value);
 
+// --------------------------ARRAY---------------------------------
+/* Constructor function that will retrun an empty array */
+array constructArray(void);
+
+/* Clears the array and frees its storage */
+void clearArray(array *a);
+
+/* Adds value to the back, doubling the storage when it is full */
+void append(array *a, uint32_t value);
+
 #endif
@@ -0,0 +1,68 @@
+#include "arena.h"
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+arena constructArena(size_t blockSize) {
+  arena a = {NULL, blockSize};
+  return a;
+}
+
+static size_t padding(arenaBlock *block) {
+  uintptr_t next = (uintptr_t) (block->data + block->used);
+  return (ARENA_ALIGNMENT - next % ARENA_ALIGNMENT) % ARENA_ALIGNMENT;
+}
+
+void *arenaAlloc(arena *a, size_t size) {
+  if (!a->head || a->head->size - a->head->used < size + padding(a->head)) {
+    // current block is full, chain a new one in front
+    size_t blockSize = size > a->blockSize ? size : a->blockSize;
+    blockSize += ARENA_ALIGNMENT;
+    arenaBlock *block = malloc(sizeof(arenaBlock) + blockSize);
+
+    if (!block) {
+      fprintf(stderr, "The malloc from the arenaAlloc function has failed\n");
+      exit(EXIT_FAILURE);
+    }
+
+    block->next = a->head;
+    block->size = blockSize;
+    block->used = 0;
+    a->head = block;
+  }
+
+  a->head->used += padding(a->head);
+  void *res = a->head->data + a->head->used;
+  a->head->used += size;
+
+  return res;
+}
+
+char *arenaCopy(arena *a, const char *start, size_t length) {
+  char *res = arenaAlloc(a, length + 1);
+
+  memcpy(res, start, length);
+  res[length] = '\0';
+
+  return res;
+}
+
+void resetArena(arena *a) {
+  if (!a->head) {
+    return;
+  }
+
+  arenaBlock *ptr = a->head->next;
+  while (ptr) {
+    arenaBlock *prev = ptr;
+    ptr = ptr->next;
+    free(prev);
+  }
+
+  a->head->next = NULL;
+  a->head->used = 0;
+}
+
+void clearArena(arena *a) {
+  resetArena(a);
+  free(a->head);
+  a->head = NULL;
+}
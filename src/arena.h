@@ -0,0 +1,54 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "headers.h"
+
+// ---------------------------MACROS-----------------------------
+#define ARENA_BLOCK_SIZE 65536
+#define SCRATCH_BLOCK_SIZE 4096
+#define ARENA_ALIGNMENT 16
+
+// -------------------------TYPES---------------------------------
+typedef struct arena arena;
+typedef struct arenaBlock arenaBlock;
+
+// -------------------------STRUCTS-------------------------------
+struct arenaBlock {
+  arenaBlock *next;
+  size_t     size;
+  size_t     used;
+  char       data[];
+};
+
+/**
+* A bump allocator: allocations are carved out of big blocks and are never
+* freed one by one, the whole arena is released (or reset) in one call
+**/
+struct arena {
+  arenaBlock *head;
+  size_t     blockSize;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+/* Constructor function that will return an empty arena */
+arena constructArena(size_t blockSize);
+
+/**
+* Returns size bytes aligned to ARENA_ALIGNMENT owned by the arena
+* Exits if there is no memory left
+**/
+void *arenaAlloc(arena *a, size_t size);
+
+/* Returns a null terminated copy of the length characters at start */
+char *arenaCopy(arena *a, const char *start, size_t length);
+
+/**
+* Releases every allocation but keeps the newest block so that the arena
+* can be refilled without calling malloc (used for per line scratch)
+**/
+void resetArena(arena *a);
+
+/* Frees all the blocks of the arena */
+void clearArena(arena *a);
+
+#endif
@@ -1,159 +1,401 @@
 #include "assemble.h"
 
 int main(int argc, char **argv) {
-  // Check for number of arguments
-  if (argc != 3) {
-    fprintf(stderr, "The function needs 2 arguments!");
-    exit(EXIT_FAILURE);
+  assembleOptions options = {false, 1, NULL, NULL, false, false, NULL};
+  int arg = 1;
+
+  // options come before the input and output files
+  while (arg < argc && argv[arg][0] == '-') {
+    if (!parseOption(argv[arg], &options)) {
+      fprintf(stderr, "Unknown option %s\n", argv[arg]);
+      exit(EXIT_FAILURE);
+    }
+    arg++;
   }
 
-  FILE *input = fopen(argv[1], "r");
-  // check file existance throw error if not found
-  if (!input) {
-    fprintf(stderr, "The file %s was not found", argv[1]);
+  if (options.cache && options.singlePass) {
+    fprintf(stderr, "The cache can't be used with the single pass\n");
+    exit(EXIT_FAILURE);
+  }
+  if (options.object && (options.singlePass || options.cache)) {
+    fprintf(stderr, "Objects can't be assembled in a single pass or cached\n");
+    exit(EXIT_FAILURE);
+  }
+  if (options.symbols && options.object) {
+    fprintf(stderr, "Objects have no addresses to write symbols for\n");
+    exit(EXIT_FAILURE);
+  }
+  if (options.optimise && (options.singlePass || options.object)) {
+    fprintf(stderr, "-O needs the whole program, not a single pass or "
+                    "an object\n");
     exit(EXIT_FAILURE);
   }
 
-  vector errorVector = constructVector();
-  uint32_t instructionsNumber;
-  map labelMapping = constructMap();
-  /**
-  * fill the mappings
-  * And after:
-  * make first pass thorugh code and map all labels with their corresponidng
-  * memmory addresses (fills labelMapping)
-  **/
+  bool assembled;
   fillAll();
-  uint32_t ldrCount = 0;
-  uint32_t lineNumber = 1;
-  char **linesFromFile;
-  linesFromFile = firstPass(input, &labelMapping, &errorVector,
-                  &instructionsNumber, &ldrCount, &lineNumber);
-  // Have checked not NULL condition in firstPass function
-  /**
-  * Make second pass now and replace all labels with their mapping
-  * also decode all instructions and throw errors if any
-  **/
-  uint32_t instructions[instructionsNumber + ldrCount];
-  rewind(input); // reset file pointer to the beginning of the file
-  secondPass(&instructionsNumber, instructions,
-             &errorVector, labelMapping, linesFromFile, lineNumber);
+
+  if (options.manifest || (arg < argc && strchr(argv[arg], ':'))) {
+    // many input:output pairs assembled concurrently
+    assembled = assembleBatch(argc - arg, argv + arg, &options);
+  } else {
+    // Check for number of arguments
+    if (argc - arg != 2) {
+      fprintf(stderr, "The function needs 2 arguments!");
+      exit(EXIT_FAILURE);
+    }
+
+    // every allocation which lives until the end of the run is owned by
+    // runArena and released in one call
+    arena runArena = constructArena(ARENA_BLOCK_SIZE);
+    vector errorVector = constructVectorInArena(&runArena);
+
+    assembled = assembleFile(argv[arg], argv[arg + 1], &options,
+                             &errorVector, &runArena);
+    // if we have compile erros print them
+    while (!isEmptyVector(errorVector)) {
+      fprintf(stderr, "%s\n", getFront(&errorVector));
+    }
+    clearArena(&runArena);
+  }
 
   // clear
   freeAll();
+  exit(assembled ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+bool assembleFile(const char *inputPath, const char *outputPath,
+                  const assembleOptions *options, vector *errorVector,
+                  arena *pool) {
+  sourceFile input;
+  // check file existance throw error if not found
+  if (!openSource(inputPath, &input)) {
+    throwFileError(errorVector, "The file %s was not found", inputPath);
+    return false;
+  }
+
+  // the words are written out in chunks as soon as they are final, or kept
+  // in memory until the object is complete or the program is optimised
+  outputWriter output = options->object ?
+                        constructOutputWriter(NULL, KEEP_ALL_WORDS) :
+                        constructOutputWriter(outputPath, options->optimise ?
+                                              KEEP_ALL_WORDS :
+                                              OUTPUT_CHUNK_WORDS);
+  objectFile object = constructObjectFile(pool);
+  map labelMapping = constructMapInArena(pool);
+  // the encodings of the last run of the file, and the ones of this run
+  lineCache previous;
+  encodingCache cache = {&previous, constructLineCache()};
+  char *cachePath = options->cache ? sidecarFile(options->cache, outputPath,
+                                                 CACHE_SUFFIX, pool) : NULL;
+  if (cachePath) {
+    loadLineCache(cachePath, &previous);
+  }
+
+  if (options->singlePass) {
+    /**
+    * encode every instruction as soon as it is read and backpatch the
+    * branches to labels which are defined later
+    **/
+    singlePass(&input, &output, errorVector, &labelMapping, pool);
+  } else {
+    /**
+    * make first pass thorugh code and map all labels with their
+    * corresponidng memmory addresses (fills labelMapping)
+    **/
+    literalPools pools = constructLiteralPools();
+    array chunkStarts = constructArray();
+    map exports = constructMapInArena(pool);
+    firstPass(&input, &labelMapping, errorVector, &pools,
+              options->jobs > 1 ? &chunkStarts : NULL, &exports, pool);
+    /**
+    * Make second pass now and replace all labels with their mapping
+    * also decode all instructions and throw errors if any
+    **/
+    if (options->object) {
+      objectPass(&output, errorVector, labelMapping, exports, &input, &pools,
+                 &object, pool);
+    } else if (options->jobs > 1) {
+      parallelSecondPass(&pools, &output, errorVector, labelMapping, &input,
+                         &chunkStarts, options->jobs,
+                         cachePath ? &cache : NULL);
+    } else {
+      secondPass(&pools, &output, errorVector, labelMapping, &input,
+                 cachePath ? &cache : NULL);
+    }
+    if (options->optimise && isEmptyVector(*errorVector)) {
+      // nothing has been flushed, the whole program is in the window
+      output.size = optimiseProgram(output.window, output.size, &pools,
+                                    &labelMapping);
+    }
+    clearLiteralPools(&pools);
+    clearArray(&chunkStarts);
+  }
+
+  if (options->symbols && isEmptyVector(*errorVector)) {
+    char *symbolPath = sidecarFile(options->symbols, outputPath,
+                                   SYMBOL_SUFFIX, pool);
+    if (!writeSymbolFile(symbolPath, labelMapping)) {
+      throwFileError(errorVector, "The file %s could not be written",
+                     symbolPath);
+    }
+  }
+
   clearMap(&labelMapping);
-  fclose(input);
+  closeSource(&input);
 
-  // if we have compile erros stop and print errors
-  if (!isEmptyVector(errorVector)) {
-    while (!isEmptyVector(errorVector)) {
-      char *error = getFront(&errorVector);
-      fprintf(stderr, "%s\n", error);
-      free(error);
+  if (cachePath && isEmptyVector(*errorVector) &&
+      !saveLineCache(cachePath, &cache.current)) {
+    // the next run will just decode every line again
+    fprintf(stderr, "The cache %s could not be written\n", cachePath);
+  }
+  if (cachePath) {
+    clearLineCache(&previous);
+    clearLineCache(&cache.current);
+  }
+
+  // if we have compile erros do not leave a partial output behind
+  if (!isEmptyVector(*errorVector)) {
+    discardOutputWriter(&output);
+    clearObjectFile(&object);
+    return false;
+  }
+
+  if (options->object) {
+    bool written = writeObjectFile(outputPath, &object);
+    discardOutputWriter(&output);
+    clearObjectFile(&object);
+    if (!written) {
+      throwFileError(errorVector, "The file %s could not be written",
+                     outputPath);
     }
+    return written;
+  }
 
-    clearVector(&errorVector);
-    exit(EXIT_FAILURE);
+  if (!closeOutputWriter(&output)) {
+    throwFileError(errorVector, "The file %s could not be written",
+                   outputPath);
+    return false;
+  }
+  return true;
+}
+
+bool assembleBatch(int count, char **pairs, const assembleOptions *options) {
+  arena runArena = constructArena(ARENA_BLOCK_SIZE);
+  vector paths = constructVectorInArena(&runArena);
+
+  for (int i = 0; i < count; i++) {
+    putBack(&paths, pairs[i]);
+  }
+  if (options->manifest && !readManifest(options->manifest, &paths)) {
+    fprintf(stderr, "The file %s was not found\n", options->manifest);
+    clearArena(&runArena);
+    return false;
+  }
+
+  if ((options->cache && *options->cache) ||
+      (options->symbols && *options->symbols)) {
+    // every file needs a cache and symbols of its own
+    fprintf(stderr, "--cache=FILE and --symbols=FILE can only be used with "
+                    "a single file\n");
+    clearArena(&runArena);
+    return false;
   }
 
-  FILE *output = fopen(argv[2], "wb");
-  fwrite(instructions, sizeof(uint32_t), instructionsNumber, output);
-  fclose(output);
-  clearVector(&errorVector);
-  clearLinesFromFile(linesFromFile);
-  exit(EXIT_SUCCESS);
+  // every file is assembled serially by one thread of the pool
+  assembleOptions fileOptions = *options;
+  fileOptions.jobs = 1;
+
+  count = paths.size;
+  assembleJob *jobs = allocate(&runArena, count * sizeof(assembleJob));
+  bool assembled = true;
+
+  for (int i = 0; i < count; i++) {
+    assembleJob *job = &jobs[i];
+    job->pair      = getFront(&paths);
+    job->options   = &fileOptions;
+    job->pool      = constructArena(ARENA_BLOCK_SIZE);
+    job->errors    = constructVectorInArena(&job->pool);
+    job->assembled = false;
+    if (!splitPair(job->pair, &job->input, &job->output)) {
+      fprintf(stderr, "%s is not an input:output pair\n", job->pair);
+      assembled = false;
+    }
+  }
+
+  if (assembled) {
+    workerPool workers;
+    int threads = options->jobs < count ? options->jobs : count;
+    if (threads > 1 && constructWorkerPool(&workers, threads)) {
+      runJobs(&workers, assembleJobFile, jobs, sizeof(assembleJob), count);
+      clearWorkerPool(&workers);
+    } else {
+      for (int i = 0; i < count; i++) {
+        assembleJobFile(&jobs[i]);
+      }
+    }
+  }
+
+  // report the errors in the order the files were given
+  for (int i = 0; i < count; i++) {
+    while (!isEmptyVector(jobs[i].errors)) {
+      fprintf(stderr, "%s: %s\n", jobs[i].input, getFront(&jobs[i].errors));
+    }
+    assembled = assembled && jobs[i].assembled;
+    clearArena(&jobs[i].pool);
+  }
+
+  clearArena(&runArena);
+  return assembled;
 }
 
-char **firstPass(FILE *input, map *labelMapping, vector *errorVector,
-      uint32_t *instructionsNumber, uint32_t *ldrCount, uint32_t *lineNumber) {
-  uint32_t currentMemoryLocation = 0;
-  *ldrCount = 0;
-  vector currentLabels = constructVector();
-  char buffer[MAX_LINE_LENGTH];
-  /*Allocate memory for the array of lines*/
-  char **linesFromFile = (char **) malloc(NUMBER_OF_LINES * sizeof(char *));
-  for(int i = 0; i < NUMBER_OF_LINES; i++) {
-    linesFromFile[i] = (char *) malloc((MAX_LINE_LENGTH + 1) * sizeof(char));
-    if(!linesFromFile) {
-      perror("malloc");
-      exit(EXIT_FAILURE);
+void assembleJobFile(void *job) {
+  assembleJob *j = job;
+
+  j->assembled = assembleFile(j->input, j->output, j->options, &j->errors,
+                              &j->pool);
+}
+
+bool readManifest(const char *path, vector *pairs) {
+  sourceFile manifest;
+  if (!openSource(path, &manifest)) {
+    return false;
+  }
+
+  for (uint32_t ln = 0; ln < manifest.lineCount; ln++) {
+    int length;
+    const char *line = getLine(&manifest, ln, &length);
+
+    // trim the line, skip it if it is empty or a comment
+    while (length && strchr(DELIMITERS, line[0])) {
+      line++;
+      length--;
+    }
+    while (length && strchr(DELIMITERS, line[length - 1])) {
+      length--;
+    }
+    if (length && line[0] != COMMENT_START) {
+      char pair[length + 1];
+      memcpy(pair, line, length);
+      pair[length] = '\0';
+      putBack(pairs, pair);
     }
   }
-  if(!linesFromFile) {
-    perror("malloc");
-    exit(EXIT_FAILURE);
+
+  closeSource(&manifest);
+  return true;
+}
+
+bool splitPair(char *pair, char **input, char **output) {
+  char *separator = strpbrk(pair, ": \t");
+  if (!separator || separator == pair) {
+    return false;
+  }
+
+  *input  = pair;
+  *output = separator + strspn(separator, ": \t");
+  *separator = '\0';
+  return **output != '\0';
+}
+
+bool parseOption(char *option, assembleOptions *options) {
+  if (!strcmp(option, "-s") || !strcmp(option, "--single-pass")) {
+    options->singlePass = true;
+  } else if (!strcmp(option, "-c") || !strcmp(option, "--object")) {
+    options->object = true;
+  } else if (!strcmp(option, "-O")) {
+    options->optimise = true;
+  } else if (!strcmp(option, "--cache")) {
+    options->cache = "";
+  } else if (!strncmp(option, "--cache=", 8) && option[8]) {
+    options->cache = option + 8;
+  } else if (!strcmp(option, "--symbols")) {
+    options->symbols = "";
+  } else if (!strncmp(option, "--symbols=", 10) && option[10]) {
+    options->symbols = option + 10;
+  } else if (!strncmp(option, "--manifest=", 11)) {
+    options->manifest = option + 11;
+  } else if (!strncmp(option, "-j", 2) || !strncmp(option, "--jobs=", 7)) {
+    options->jobs = atoi(option + (option[1] == 'j' ? 2 : 7));
+    return options->jobs > 0;
+  } else {
+    return false;
   }
-  /*End memory allocation for array of lines*/
-  *instructionsNumber = 0;
-
-  while(fgets(buffer, MAX_LINE_LENGTH, input)) {
-    /*Perform dynamic expansion of lines array*/
-    if((*lineNumber - 1) >= NUMBER_OF_LINES) {
-     countDynamicExpansions++;
-     //increment global variable countDynamicExpansions
-     char **reallocatedArray =
-     realloc(linesFromFile,
-             countDynamicExpansions * NUMBER_OF_LINES * sizeof(char *));
-             printf("%s\n", "I reallocated");
-     if(reallocatedArray) {
-        linesFromFile = reallocatedArray;
-     } else {
-       perror("realloc");
-       exit(EXIT_FAILURE);
-     }
-    }
-    /*End dynamic expansion*/
-    strcpy(linesFromFile[*lineNumber - 1], buffer);
-    vector tokens = tokenise(buffer, DELIMITERS);
-    char *lineNo = uintToString(*lineNumber);
+
+  return true;
+}
+
+void firstPass(sourceFile *source, map *labelMapping, vector *errorVector,
+               literalPools *pools, array *chunkStarts, map *exports,
+               arena *pool) {
+  PROBE1(assemble, pass__start, "first");
+  uint32_t currentMemoryLocation = 0;
+  vector currentLabels = constructVectorInArena(pool);
+  arena scratch = constructArena(SCRATCH_BLOCK_SIZE);
+
+  for (uint32_t ln = 0; ln < source->lineCount; ln++) {
+    int length;
+    const char *line = getLine(source, ln, &length);
+    tokenList tokens = tokenise(line, length);
+    char *lineNo = uintToString(&scratch, ln + 1);
+    if (chunkStarts && !(ln % PASS_CHUNK_LINES)) {
+      // where the chunk starts and the pool its literals go to
+      append(chunkStarts, currentMemoryLocation);
+      append(chunkStarts, pools->size - 1);
+    }
     // check for all tokens see if there are labels
     // if there are labels add all of them to a vector list and
     // map all labels with the memorry address of the next instruction
-    while (!isEmptyVector(tokens)) {
-      char *token = peekFront(tokens);
+    while (hasTokens(&tokens)) {
+      token *t = nextToken(&tokens);
 
-      if (getType(token) == LABEL) {
-        token[strlen(token) - 1] = '\0';
-        if (get(*labelMapping, token) || contains(currentLabels, token)) {
+      if (t->type == LABEL) {
+        char *label = arenaCopy(&scratch, t->start, t->length - 1);
+        if (get(*labelMapping, label) || contains(currentLabels, label)) {
           // if this label already exists in the mapping this means
           // that we have multiple definitions of the same label
           // therefore throw an error message
-          throwLabelError(token, errorVector, lineNo);
+          throwLabelError(t, errorVector, lineNo);
         } else {
-          putBack(&currentLabels, token);
+          putBack(&currentLabels, label);
         }
       }
 
-      if (getType(token) == INSTRUCTION) {
-        // if the instruction is a ldr instruction and the <=expression>
-        // is more than 0xFF we need to store the value at the bottom of the
-        // binary file
-        // we will assume that the argument is more than 0xFF and if it is
-        // not then we will just not use the remaining space
-        if (!strcmp(token, "ldr")) {
-          (*ldrCount)++;
+      if (t->type == INSTRUCTION && t->value == GLOBAL_DIRECTIVE) {
+        // takes no space, a missing label is reported by the second pass
+        if (hasTokens(&tokens)) {
+          token *name = nextToken(&tokens);
+          put(exports, arenaCopy(pool, name->start, name->length), ln + 1);
         }
+        continue;
+      }
 
-        // if we found a valid instruction
-        // map all current unmapped labels
-        // to this current memmory location
-        // and advance memory
+      if (t->type == INSTRUCTION) {
+        // map all current unmapped labels to this current memmory location
         while (!isEmptyVector(currentLabels)) {
-          // map all labels to current memorry location
-          char *label = getFront(&currentLabels);
-          put(labelMapping, label, currentMemoryLocation);
-          free(label);
+          put(labelMapping, getFront(&currentLabels), currentMemoryLocation);
         }
-        currentMemoryLocation++;
-        (*instructionsNumber)++;
-      }
 
-      getComment(&tokens);
+        if (t->value == LTORG_DIRECTIVE) {
+          // the pool is placed here and the labels before it label it
+          literalPool *placed = placePool(pools, currentMemoryLocation);
+          currentMemoryLocation += poolSize(placed);
+          continue;
+        }
 
-      free(getFront(&tokens));
+        // if the instruction is a ldr instruction and the <=expression>
+        // is cheaper to load than to build its value is stored once in the
+        // next pool
+        if (usesLiteralPool(t, &tokens)) {
+          addLiteral(currentPool(pools), tokens.tokens[tokens.position + 1]
+                                           .value);
+        }
+        // a synthesised constant takes a word for each of its instructions
+        uint32_t chunks[MAX_IMMEDIATE_CHUNKS];
+        int length = sequenceLength(&tokens, tokens.position - 1, chunks);
+        currentMemoryLocation += length ? length : 1;
+      }
     }
-    free(lineNo);
-    (*lineNumber)++;
+    resetArena(&scratch);
   }
 
   // map all remaining unmached labels to current memory location
@@ -161,145 +403,584 @@ char **firstPass(FILE *input, map *labelMapping, vector *errorVector,
     // map all labels to current memorry location
     put(labelMapping, getFront(&currentLabels), currentMemoryLocation);
   }
-  return linesFromFile;
-}
-
-void secondPass(uint32_t *instructionsNumber, uint32_t instructions[],
-              vector *errorVector, map labelMapping,
-              char **linesFromFile, uint32_t lineNumber) {
-  //char buffer[MAX_LINE_LENGTH];
-  uint32_t PC = 0;
-  uint32_t ln = 1;
-  vector addresses = constructVector();
-  while(ln != lineNumber) {
-    vector tokens = tokenise(linesFromFile[ln - 1], DELIMITERS);
-    char *lineNo = uintToString(ln);
-    while (!isEmptyVector(tokens)) {
-      char *token = peekFront(tokens);
-      if (getType(token) == INSTRUCTION) {
-        // if there is a valid isntruction decode it and increase
-        // instruction counter
-        instructions[PC] = decode(&tokens, &addresses, PC, *instructionsNumber,
-                      labelMapping, errorVector, lineNo);
-        PC++;
-      } else if (getType(token) == LABEL) {
-        // we have a label so we just remove it
-        free(getFront(&tokens));
+  // the last pool goes at the end of the program
+  currentPool(pools)->start = currentMemoryLocation;
+  clearArena(&scratch);
+  PROBE1(assemble, pass__done, "first");
+}
+
+void skipGlobal(tokenList *tokens, vector *errorVector, char *ln) {
+  token *directive = nextToken(tokens);
+
+  if (hasTokens(tokens)) {
+    nextToken(tokens);
+  } else {
+    throwGlobalMissingError(directive, errorVector, ln);
+  }
+}
+
+bool usesLiteralPool(const token *instruction, tokenList *operands) {
+  token *expression = &operands->tokens[operands->position + 1];
+
+  return mnemonicIs(instruction, "ldr") &&
+         operands->position + 1 < operands->size &&
+         expression->type == EXPRESSION_EQUAL &&
+         prefersLiteral(expression->value);
+}
+
+int immediateChunks(uint32_t value, uint32_t chunks[MAX_IMMEDIATE_CHUNKS]) {
+  int best = MAX_IMMEDIATE_CHUNKS + 1;
+
+  if (!value) {
+    chunks[0] = 0;
+    return 1;
+  }
+
+  // split greedily into 8 bit windows at even positions, starting at every
+  // even position since the windows may wrap around
+  for (int start = 0; start < INSTRUCTION_SIZE; start += 2) {
+    uint32_t rest = value;
+    uint32_t found[MAX_IMMEDIATE_CHUNKS];
+    int n = 0;
+
+    for (int p = start; rest && n < best && p < start + INSTRUCTION_SIZE;) {
+      int shift = p % INSTRUCTION_SIZE;
+      uint32_t pair = (0x3u << shift) | (0x3u >> (INSTRUCTION_SIZE - shift));
+      if (rest & pair) {
+        uint32_t window = (0xFFu << shift) |
+                          (shift ? 0xFFu >> (INSTRUCTION_SIZE - shift) : 0);
+        if (n == MAX_IMMEDIATE_CHUNKS) {
+          n++;
+          break;
+        }
+        found[n++] = rest & window;
+        rest &= ~window;
+        p += 8;
       } else {
-	getComment(&tokens);
-	if (!isEmptyVector(tokens)) {
-          throwUndefinedError(token, errorVector, lineNo);
-          // throw error because instruction is undefined
-          free(getFront(&tokens));
+        p += 2;
+      }
+    }
+
+    if (!rest && n < best) {
+      best = n;
+      memcpy(chunks, found, n * sizeof(uint32_t));
+    }
+  }
+
+  return best;
+}
+
+bool prefersLiteral(uint32_t value) {
+  uint32_t chunks[MAX_IMMEDIATE_CHUNKS];
+  int n = immediateChunks(value, chunks);
+
+  // k sequences against k loads and a pool word: as the costs are whole
+  // numbers the sequences are strictly cheaper for some k only if a single
+  // sequence is strictly cheaper than a single load, and then for every k
+  return n > 1 && n * SEQUENCE_INSTRUCTION_COST >= LITERAL_LOAD_COST;
+}
+
+int sequenceLength(const tokenList *tokens, int instruction,
+                   uint32_t chunks[MAX_IMMEDIATE_CHUNKS]) {
+  const token *t = &tokens->tokens[instruction];
+
+  if (instruction + 2 >= tokens->size ||
+      tokens->tokens[instruction + 1].type != REGISTER ||
+      (instruction + 3 < tokens->size &&
+       tokens->tokens[instruction + 3].type == SHIFT)) {
+    return 0;
+  }
+
+  const token *expression = &tokens->tokens[instruction + 2];
+  bool mov = mnemonicIs(t, "mov") && expression->type == EXPRESSION_TAG;
+  bool ldr = mnemonicIs(t, "ldr") && expression->type == EXPRESSION_EQUAL &&
+             !prefersLiteral(expression->value);
+  int n = immediateChunks(expression->value, chunks);
+
+  return (mov || ldr) && n > 1 ? n : 0;
+}
+
+int synthesiseConstant(tokenList *tokens, uint32_t words[MAX_IMMEDIATE_CHUNKS],
+                       vector *errorVector, char *ln) {
+  uint32_t chunks[MAX_IMMEDIATE_CHUNKS];
+  int n = sequenceLength(tokens, tokens->position, chunks);
+
+  if (!n) {
+    return 0;
+  }
+
+  // mov Rd, #<first chunk> then orr Rd, Rd, #<chunk> for every other chunk
+  // all with the condition of the instruction, only the last one sets the
+  // flags
+  token *instruction = nextToken(tokens);
+  token *rd = nextToken(tokens);
+  nextToken(tokens);
+  for (int i = 0; i < n; i++) {
+    char text[MAX_MNEMONIC_LENGTH];
+    token immediate = {"#", 1, EXPRESSION_TAG, chunks[i]};
+    token sequence[] = {renameInstruction(instruction, i ? "orr" : "mov",
+                                          i == n - 1, text),
+                        *rd, *rd, immediate};
+    if (!i) {
+      // mov Rd, #<first chunk>
+      sequence[2] = immediate;
+    }
+    tokenList rewritten = rewriteTokens(sequence, i ? 4 : 3, NULL);
+    words[i] = decodeDataProcessing(&rewritten, errorVector, ln);
+  }
+
+  return n;
+}
+
+char *sidecarFile(const char *path, const char *outputPath,
+                  const char *suffix, arena *pool) {
+  if (*path) {
+    return arenaCopy(pool, path, strlen(path));
+  }
+
+  char *sidecar = allocate(pool, strlen(outputPath) + strlen(suffix) + 1);
+  strcpy(sidecar, outputPath);
+  strcat(sidecar, suffix);
+  return sidecar;
+}
+
+void secondPass(literalPools *pools, outputWriter *output,
+                vector *errorVector, map labelMapping, sourceFile *source,
+                encodingCache *cache) {
+  PROBE1(assemble, pass__start, "second");
+  encodeLines(source, 0, source->lineCount, pools, 0, output, labelMapping,
+              errorVector, cache, NULL);
+
+  // put the last pool at the end of the file
+  emitPool(output, NULL, currentPool(pools));
+  PROBE1(assemble, pass__done, "second");
+}
+
+void emitPool(outputWriter *output, fixupList *fixups,
+              const literalPool *pool) {
+  for (uint32_t i = 0; i < poolSize(pool); i++) {
+    emitInstruction(output, fixups, pool->values.values[i]);
+  }
+}
+
+void encodeLines(sourceFile *source, uint32_t firstLine, uint32_t lastLine,
+                 literalPools *pools, int poolIndex, outputWriter *output,
+                 map labelMapping, vector *errorVector, encodingCache *cache,
+                 fixupList *fixups) {
+  arena scratch = constructArena(SCRATCH_BLOCK_SIZE);
+  uint32_t words[MAX_IMMEDIATE_CHUNKS];
+  int n;
+  for (uint32_t ln = firstLine; ln < lastLine; ln++) {
+    int length;
+    const char *line = getLine(source, ln, &length);
+    tokenList tokens = tokenise(line, length);
+    char *lineNo = uintToString(&scratch, ln + 1);
+    while (hasTokens(&tokens)) {
+      token *t = peekToken(&tokens);
+      if (t->type == INSTRUCTION && t->value == LTORG_DIRECTIVE) {
+        // the pool placed by the first pass
+        emitPool(output, NULL, &pools->pools[poolIndex++]);
+        nextToken(&tokens);
+      } else if (t->type == INSTRUCTION && t->value == GLOBAL_DIRECTIVE) {
+        // the exports are collected by the first pass
+        skipGlobal(&tokens, errorVector, lineNo);
+      } else if (t->type == INSTRUCTION &&
+                 (n = synthesiseConstant(&tokens, words, errorVector,
+                                         lineNo))) {
+        // a constant built by a mov/orr sequence
+        for (int i = 0; i < n; i++) {
+          emitInstruction(output, NULL, words[i]);
         }
+      } else if (t->type == INSTRUCTION) {
+        literalPool *pool = &pools->pools[poolIndex];
+        uint32_t instructionNumber = wordCount(output);
+        uint64_t key;
+        uint32_t word;
+        bool cacheable = cache && instructionKey(&tokens, instructionNumber,
+                                                 pool, labelMapping, &key);
+
+        if (cacheable && findCachedWord(cache->previous, key, &word)) {
+          // same text and same labels as in the last run, no need to decode
+          tokens.position = tokens.size;
+        } else {
+          // if there is a valid isntruction decode it and increase
+          // instruction counter
+          int errors = errorVector->size;
+          word = decode(&tokens, pool, instructionNumber, labelMapping,
+                        fixups, errorVector, lineNo);
+          // only a line which is a single valid instruction is cached
+          cacheable = cacheable && !hasTokens(&tokens) &&
+                      errorVector->size == errors;
+        }
+
+        if (cacheable) {
+          cacheWord(&cache->current, key, word);
+        }
+        emitInstruction(output, NULL, word);
+      } else if (t->type == LABEL) {
+        // we have a label so we just skip it
+        nextToken(&tokens);
+      } else {
+        // throw error because instruction is undefined
+        throwUndefinedError(t, errorVector, lineNo);
+        nextToken(&tokens);
       }
     }
-    ln++;
-    free(lineNo);
+    resetArena(&scratch);
   }
+  clearArena(&scratch);
+}
 
-  // put all ldr addresses > 0xFF at the end of the file
-  while (!isEmptyVector(addresses)) {
-    char *address = getFront(&addresses);
-    instructions[PC] = getExpression(address, NULL, 0);
-    free(address);
-    PC++;
+bool instructionKey(tokenList *tokens, uint32_t instructionNumber,
+                    const literalPool *pool, map labelMapping,
+                    uint64_t *key) {
+  token *instruction = &tokens->tokens[tokens->position];
+  token *last = &tokens->tokens[tokens->size - 1];
+  int32_t dependency = 0;
+  uint32_t slot;
+
+  tokens->position++;
+  if (usesLiteralPool(instruction, tokens)) {
+    // the offset to the literal pool slot is encoded
+    if (pool->start == UNPLACED_POOL ||
+        !findLiteral(pool, tokens->tokens[tokens->position + 1].value,
+                     &slot)) {
+      tokens->position--;
+      return false;
+    }
+    dependency = pool->start + slot - instructionNumber;
+  }
+  tokens->position--;
+
+  if (instruction->value == 3) {
+    // the offset to the label is encoded
+    uint32_t *target;
+    if (tokens->position + 1 >= tokens->size ||
+        !(target = getSlice(labelMapping,
+                            tokens->tokens[tokens->position + 1].start,
+                            tokens->tokens[tokens->position + 1].length))) {
+      // undefined label, decode reports it
+      return false;
+    }
+    dependency = *target - instructionNumber;
   }
 
-  *instructionsNumber = PC;
+  *key = lineKey(instruction->start,
+                 last->start + last->length - instruction->start, dependency);
+  return true;
 }
 
-void getComment(vector *tokens) {
-  char *token = peekFront(*tokens);
-  if (token[0] == '@') {
-    clearVector(tokens);
+void encodeChunk(void *job) {
+  passChunk *chunk = job;
+
+  encodeLines(chunk->source, chunk->firstLine, chunk->lastLine, chunk->pools,
+              chunk->firstPool, &chunk->words, *chunk->labelMapping,
+              &chunk->errors, chunk->cache.previous ? &chunk->cache : NULL,
+              NULL);
+}
+
+void objectPass(outputWriter *output, vector *errorVector, map labelMapping,
+                map exports, sourceFile *source, literalPools *pools,
+                objectFile *object, arena *pool) {
+  PROBE1(assemble, pass__start, "object");
+  fixupList fixups = constructFixupList(pool);
+
+  // the .ltorg pools are part of the code but the last pool is placed by the
+  // linker, so the branches to other modules and the loads from the last
+  // pool become fixups
+  currentPool(pools)->start = UNPLACED_POOL;
+  encodeLines(source, 0, source->lineCount, pools, 0, output, labelMapping,
+              errorVector, NULL, &fixups);
+
+  for (uint32_t i = 0; i < output->size; i++) {
+    append(&object->code, output->window[i]);
+  }
+  for (uint32_t i = 0; i < poolSize(currentPool(pools)); i++) {
+    append(&object->literals, currentPool(pools)->values.values[i]);
+  }
+
+  // only the labels named by .global are visible to the other modules, the
+  // branches to the others have been resolved in the module
+  for (mapNode *ptr = exports.head; ptr; ptr = ptr->next) {
+    uint32_t *value = get(labelMapping, ptr->key);
+    if (value) {
+      addSymbol(object, ptr->key, strlen(ptr->key), *value, true);
+    } else {
+      throwError(errorVector, uintToString(pool, ptr->value),
+                 "The exported label %s is not defined.", ptr->key);
+    }
   }
+
+  // the labels which are still pending are defined by another module
+  for (mapNode *ptr = fixups.pending.head; ptr; ptr = ptr->next) {
+    int label = addSymbol(object, ptr->key, strlen(ptr->key), 0, false);
+    for (int i = ptr->value; i != NO_FIXUP; i = fixups.fixups[i].next) {
+      addRelocation(object, BRANCH_RELOCATION, fixups.fixups[i].instruction,
+                    label);
+    }
+  }
+
+  for (int i = 0; i < fixups.size; i++) {
+    if (fixups.fixups[i].kind == LITERAL_FIXUP) {
+      addRelocation(object, LITERAL_RELOCATION, fixups.fixups[i].instruction,
+                    fixups.fixups[i].target);
+    }
+  }
+
+  clearFixupList(&fixups);
+  PROBE1(assemble, pass__done, "object");
 }
 
-uint32_t decode(vector *tokens, vector *addresses, uint32_t instructionNumber,
-                uint32_t instructionsNumber, map labelMapping,
+void parallelSecondPass(literalPools *pools, outputWriter *output,
+              vector *errorVector, map labelMapping, sourceFile *source,
+              array *chunkStarts, int jobs, encodingCache *cache) {
+  workerPool workers;
+  if (!constructWorkerPool(&workers, jobs)) {
+    // no threads, encode serially
+    secondPass(pools, output, errorVector, labelMapping, source, cache);
+    return;
+  }
+  PROBE1(assemble, pass__start, "parallel");
+
+  int chunks = chunkStarts->size / 2;
+  int batchSize = jobs * CHUNKS_PER_WORKER;
+  passChunk *batch = malloc(batchSize * sizeof(passChunk));
+  if (!batch) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+
+  // encode batchSize chunks at a time so that the memory stays bounded
+  for (int first = 0; first < chunks; first += batchSize) {
+    int n = chunks - first < batchSize ? chunks - first : batchSize;
+
+    for (int i = 0; i < n; i++) {
+      passChunk *chunk = &batch[i];
+      uint32_t lastLine = (first + i + 1) * PASS_CHUNK_LINES;
+      chunk->source = source;
+      chunk->labelMapping = &labelMapping;
+      chunk->pools = pools;
+      chunk->firstLine = (first + i) * PASS_CHUNK_LINES;
+      chunk->lastLine = lastLine < source->lineCount ? lastLine
+                                                     : source->lineCount;
+      chunk->firstPool = chunkStarts->values[2 * (first + i) + 1];
+      chunk->words = constructOutputWriter(NULL, KEEP_ALL_WORDS);
+      chunk->words.base = chunkStarts->values[2 * (first + i)];
+      chunk->pool = constructArena(SCRATCH_BLOCK_SIZE);
+      chunk->errors = constructVectorInArena(&chunk->pool);
+      // the chunks share the last run and each records its own encodings
+      chunk->cache.previous = cache ? cache->previous : NULL;
+      chunk->cache.current = constructLineCache();
+    }
+
+    runJobs(&workers, encodeChunk, batch, sizeof(passChunk), n);
+
+    // stitch the chunks together in order
+    for (int i = 0; i < n; i++) {
+      passChunk *chunk = &batch[i];
+      for (uint32_t j = 0; j < chunk->words.size; j++) {
+        emitInstruction(output, NULL, chunk->words.window[j]);
+      }
+      while (!isEmptyVector(chunk->errors)) {
+        putBack(errorVector, getFront(&chunk->errors));
+      }
+      if (cache) {
+        mergeLineCache(&cache->current, &chunk->cache.current);
+      }
+      clearLineCache(&chunk->cache.current);
+      discardOutputWriter(&chunk->words);
+      clearArena(&chunk->pool);
+    }
+  }
+
+  // put the last pool at the end of the file
+  emitPool(output, NULL, currentPool(pools));
+
+  free(batch);
+  clearWorkerPool(&workers);
+  PROBE1(assemble, pass__done, "parallel");
+}
+
+void singlePass(sourceFile *source, outputWriter *output, vector *errorVector,
+                map *labelMapping, arena *pool) {
+  PROBE1(assemble, pass__start, "single");
+  fixupList fixups = constructFixupList(pool);
+  literalPools pools = constructLiteralPools();
+  arena scratch = constructArena(SCRATCH_BLOCK_SIZE);
+  uint32_t words[MAX_IMMEDIATE_CHUNKS];
+  bool inRange = true;
+  int n;
+  for (uint32_t ln = 0; ln < source->lineCount; ln++) {
+    int length;
+    const char *line = getLine(source, ln, &length);
+    tokenList tokens = tokenise(line, length);
+    char *lineNo = uintToString(&scratch, ln + 1);
+    fixups.line = ln + 1;
+    while (hasTokens(&tokens)) {
+      token *t = peekToken(&tokens);
+      if (t->type == INSTRUCTION && t->value == LTORG_DIRECTIVE) {
+        // place the pool here and point its loads at it
+        literalPool *placed = placePool(&pools, wordCount(output));
+        emitPool(output, &fixups, placed);
+        inRange &= resolveLiterals(&fixups, placed->start, output);
+        nextToken(&tokens);
+      } else if (t->type == INSTRUCTION && t->value == GLOBAL_DIRECTIVE) {
+        // a single file has no other modules to export labels to
+        skipGlobal(&tokens, errorVector, lineNo);
+      } else if (t->type == INSTRUCTION &&
+                 (n = synthesiseConstant(&tokens, words, errorVector,
+                                         lineNo))) {
+        // a constant built by a mov/orr sequence
+        for (int i = 0; i < n; i++) {
+          emitInstruction(output, &fixups, words[i]);
+        }
+      } else if (t->type == INSTRUCTION) {
+        // the pool isn't placed yet so literal loads are fixups as well
+        emitInstruction(output, &fixups, decode(&tokens, currentPool(&pools),
+                      wordCount(output), *labelMapping, &fixups,
+                      errorVector, lineNo));
+      } else if (t->type == LABEL) {
+        // the label belongs to the next instruction
+        char *label = arenaCopy(pool, t->start, t->length - 1);
+        if (get(*labelMapping, label)) {
+          throwLabelError(t, errorVector, lineNo);
+        } else {
+          put(labelMapping, label, wordCount(output));
+          resolveLabel(&fixups, label, wordCount(output), output);
+        }
+        nextToken(&tokens);
+      } else {
+        // throw error because instruction is undefined
+        throwUndefinedError(t, errorVector, lineNo);
+        nextToken(&tokens);
+      }
+    }
+    resetArena(&scratch);
+  }
+
+  // put the last pool at the end of the file and point the loads at it
+  uint32_t poolStart = wordCount(output);
+  emitPool(output, &fixups, currentPool(&pools));
+  inRange &= resolveLiterals(&fixups, poolStart, output);
+  if (!inRange) {
+    for (int i = 0; i < fixups.size; i++) {
+      fixup *f = &fixups.fixups[i];
+      if (f->kind == LITERAL_FIXUP &&
+          !literalInRange(literalOffset(f->instruction, f->target))) {
+        throwLiteralRangeError(errorVector,
+                               uintToString(&scratch, f->line));
+      }
+    }
+  }
+
+  // every branch which is still waiting uses an undefined label
+  for (mapNode *ptr = fixups.pending.head; ptr; ptr = ptr->next) {
+    for (int i = ptr->value; i != NO_FIXUP; i = fixups.fixups[i].next) {
+      token label = {ptr->key, strlen(ptr->key), LABEL, 0};
+      throwUndefinedLabelError(&label, errorVector,
+                               uintToString(&scratch, fixups.fixups[i].line));
+    }
+  }
+
+  clearArena(&scratch);
+  clearLiteralPools(&pools);
+  clearFixupList(&fixups);
+  PROBE1(assemble, pass__done, "single");
+}
+
+void emitInstruction(outputWriter *output, fixupList *fixups, uint32_t word) {
+  if (isWindowFull(output)) {
+    // flush every word which no pending fixup can still reach
+    flushWords(output, fixups ? oldestPendingFixup(fixups)
+                              : wordCount(output));
+    if (isWindowFull(output)) {
+      // an old fixup pins the window, it will be patched in the file instead
+      flushWords(output, wordCount(output));
+    }
+  }
+
+  emitWord(output, word);
+}
+
+uint32_t decode(tokenList *tokens, literalPool *pool,
+                uint32_t instructionNumber, map labelMapping,
+                fixupList *fixups,
                 vector *errorVector, char *ln) {
-  uint32_t type = *get(ALL_INSTRUCTIONS, peekFront(*tokens));
-  switch (type) {
+  switch (peekToken(tokens)->value) {
     case 0: return decodeDataProcessing(tokens, errorVector, ln);
     case 1: return decodeMultiply(tokens, errorVector, ln);
-    case 2: return decodeSingleDataTransfer(tokens, addresses,
-                        instructionNumber, instructionsNumber, errorVector, ln);
+    case 2: return decodeSingleDataTransfer(tokens, pool, instructionNumber,
+                                            fixups, errorVector, ln);
     case 3: return decodeBranch(tokens, instructionNumber,
-                                      labelMapping, errorVector, ln);
+                                      labelMapping, fixups, errorVector, ln);
     case 4: return decodeShift(tokens, errorVector, ln);
-    case 5: // andeq r0,r0,r0 we just free 4 times
-            free(getFront(tokens));
-            free(getFront(tokens));
-            free(getFront(tokens));
-            free(getFront(tokens));
+    case 5: // andeq r0,r0,r0 we just skip 4 tokens
+            nextToken(tokens);
+            nextToken(tokens);
+            nextToken(tokens);
+            nextToken(tokens);
             return 0;
     default: //assert(false);
-             free(getFront(tokens));
+             nextToken(tokens);
              return -1;
   }
 }
 
-uint32_t decodeDataProcessing(vector *tokens, vector *errorVector, char *ln) {
-  char *instruction = getFront(tokens);
+uint32_t decodeDataProcessing(tokenList *tokens, vector *errorVector,
+                              char *ln) {
+  token *instruction = nextToken(tokens);
   uint32_t ins = 0;
-  uint32_t opcode = *get(DATA_OPCODE, instruction) << 0x15;
-  setCond(&ins, ALWAYS_CONDITION);
+  uint32_t opcode = *getSlice(DATA_OPCODE, instruction->start,
+                              instruction->baseLength) << 0x15;
+  setCond(&ins, instruction);
   // set opcode
   ins |= opcode;
-  uint32_t dataType = *get(DATA_TYPE, instruction);
+  uint32_t dataType = *getSlice(DATA_TYPE, instruction->start,
+                                instruction->baseLength);
   uint32_t rd = 0;
   uint32_t rn = 0;
   uint32_t operand2 = 0;
   uint32_t i = 0;
-  char *token;
   if (dataType != 2) {
     // we have either 0, 1 type instruction
     if (checkReg(tokens, instruction, errorVector, ln)) {
-      token = getFront(tokens);
-      rd = getDec(token + 1) << 0xC;
-      free(token);
+      rd = nextToken(tokens)->value << 0xC;
     }
   }
 
   if (dataType != 1) {
     // we have either 0, 2 type instruction
     if (checkReg(tokens, instruction, errorVector, ln)) {
-      token = getFront(tokens);
-      rn = getDec(token + 1) << 0x10;
-      free(token);
+      rn = nextToken(tokens)->value << 0x10;
     }
   }
 
-  token = peekFront(*tokens);
-  if (getType(token) != EXPRESSION_TAG &&
-      getType(token) != EXPRESSION_EQUAL &&
-            getType(token) != REGISTER) {
+  token *t = peekToken(tokens);
+  if (t->type != EXPRESSION_TAG && t->type != EXPRESSION_EQUAL &&
+      t->type != REGISTER) {
     // throw expression error
-    throwExpressionError(token, errorVector, ln);
-    free(instruction);
+    throwExpressionError(t, errorVector, ln);
     return -1;
   }
 
-  if (getType(token) == EXPRESSION_TAG || getType(token) == EXPRESSION_EQUAL) {
+  if (t->type == EXPRESSION_TAG || t->type == EXPRESSION_EQUAL) {
     // decode expression and set bit i to 1
-    operand2 = getExpression(token, errorVector, ln);
+    operand2 = getExpression(t, errorVector, ln);
     i = 1;
   } else {
     // we have a register
-    operand2 = getDec(token + 1);
+    operand2 = t->value;
   }
-  free(getFront(tokens));
+  nextToken(tokens);
 
-  if (dataType == 2) {
+  if (dataType == 2 || instruction->setFlags) {
     // we have third type of instruction
-    // with syntax <opcode> Rn, <Operand2>
+    // with syntax <opcode> Rn, <Operand2>, or an S suffix
     // set S bit to 1
     ins |= 0x1 << 0x14;
   }
 
-  token = peekFront(*tokens);
-  if (isShift(token)) {
+  if (peekToken(tokens)->type == SHIFT) {
     getShift(tokens, &operand2, errorVector, ln);
   }
 
@@ -312,17 +993,15 @@ uint32_t decodeDataProcessing(vector *tokens, vector *errorVector, char *ln) {
   // set operand2
   ins |= operand2;
 
-  free(instruction);
-
   return ins;
 }
 
-uint32_t decodeMultiply(vector *tokens, vector *errorVector, char *ln) {
-  char *multType = (char *) getFront(tokens);
+uint32_t decodeMultiply(tokenList *tokens, vector *errorVector, char *ln) {
+  token *multType = nextToken(tokens);
   // set bits 4-7, same for mul and mla
   uint32_t instr = 0x9 << 0x4;
   // set cond
-  setCond(&instr, ALWAYS_CONDITION);
+  setCond(&instr, multType);
 
   uint32_t acc = 0;
   uint32_t rd = 0;
@@ -332,35 +1011,29 @@ uint32_t decodeMultiply(vector *tokens, vector *errorVector, char *ln) {
 
   // "mul"/"mla" set common registers (rd, rm, rs)
   if(checkReg(tokens, multType, errorVector, ln)) {
-    char *token = (char *) getFront(tokens);
-    rd = getDec(token + 1) << 0x10;
-    free(token);
+    rd = nextToken(tokens)->value << 0x10;
   }
 
   if(checkReg(tokens, multType, errorVector, ln)) {
-    char *token = (char *) getFront(tokens);
-    rm = getDec(token + 1);
-    free(token);
+    rm = nextToken(tokens)->value;
   }
 
   if(checkReg(tokens, multType, errorVector, ln)) {
-    char *token = (char *) getFront(tokens);
-    rs = getDec(token + 1) << 0x8;
-    free(token);
+    rs = nextToken(tokens)->value << 0x8;
   }
 
  // "mla" instr case
-  if(!strcmp(multType, "mla")) {
+  if(mnemonicIs(multType, "mla")) {
     //set bit 21 (Accumulator)
     acc = 0x1 << 0x15;
 
     if(checkReg(tokens, multType, errorVector, ln)) {
-      char *token = (char *) getFront(tokens);
-      rn = getDec(token + 1) << 0xC;
-      free(token);
+      rn = nextToken(tokens)->value << 0xC;
     }
   }
 
+  // set S bit 20
+  instr |= multType->setFlags << 0x14;
   // set acc
   instr |= acc;
   // set rd
@@ -372,157 +1045,110 @@ uint32_t decodeMultiply(vector *tokens, vector *errorVector, char *ln) {
   // set rn
   instr |= rn;
 
-  free(multType);
-
   return instr;
 }
 
 // helper function to check if incoming token is a valid register
-bool checkReg(vector *tokens, char *instr,
+bool checkReg(tokenList *tokens, const token *instr,
                 vector *errorVector, char *ln) {
-  char *reg = (char *) peekFront(*tokens);
-  if(!reg || getType(reg) == INSTRUCTION) {
+  token *reg = peekToken(tokens);
+  if(reg->type == END_OF_LINE || reg->type == INSTRUCTION) {
     throwExpressionMissingError(instr, errorVector, ln);
     return false;
   }
 
-  if (getType(reg) != REGISTER) {
+  if (reg->type != REGISTER) {
     throwRegisterError(reg, errorVector, ln);
-    free(getFront(tokens));
+    nextToken(tokens);
     return false;
   }
 
   return true;
 }
 
-void getBracketExpr(vector *tokens, int *rn, int32_t *offset, int *i, int *u,
-                    vector *errorVector, char *ln) {
-  char *token;
-  int tokenSize = 0;
-  vector bracketExpr = constructVector();
+bool getOffsetExpr(tokenList *tokens, int32_t *offset, int *i, int *u,
+                   vector *errorVector, char *ln) {
+  token *t = peekToken(tokens);
 
-  // remove the square brackets from the existing tokens
-  do {
-    token = getFront(tokens);
-    tokenSize = strlen(token);
-    char *newToken = token;
+  if (t->type == MINUS) {
+    *u = 0;
+    nextToken(tokens);
+    t = peekToken(tokens);
+  }
 
-    if (token[0] == '[') {
-      newToken++;
-    }
+  if (t->type == EXPRESSION_TAG) {
+    *offset = nextToken(tokens)->value;
+  } else if (t->type == REGISTER) {
+    *offset = nextToken(tokens)->value;
+    *i = 1;
 
-    if (token[tokenSize - 1] == ']') {
-      token[tokenSize - 1] = '\0';
-      if (strlen(token)) {
-        // token not empty
-        putBack(&bracketExpr, newToken);
-      }
-      free(token);
-      break;
+    if (peekToken(tokens)->type == SHIFT) {
+      uint32_t aux = *offset;
+      getShift(tokens, &aux, errorVector, ln);
+      *offset = aux;
     }
+  } else {
+    return false;
+  }
 
-    putBack(&bracketExpr, newToken);
-
-    free(token);
-  } while (!isEmptyVector(*tokens));
-
-  token = getFront(&bracketExpr);
-  *rn = getDec(token + 1);
-  free(token);
-
-  token = getFront(&bracketExpr);
+  return true;
+}
 
-  if (token) {
-    if (!strcmp(token, "-")) {
-      u = 0;
-      free(token);
-      token = getFront(&bracketExpr);
-    } else if (token[0] == '-') {
-      token++;
-      u = 0;
-    }
+void getBracketExpr(tokenList *tokens, int *rn, int32_t *offset, int *i,
+                    int *u, vector *errorVector, char *ln) {
+  // skip the opening square bracket
+  nextToken(tokens);
 
-    if (getType(token) == EXPRESSION_TAG) {
-      *offset = getExpression(token, NULL, 0);
-    } else if (getType(token) == REGISTER) {
-      *offset = getDec(token + 1);
-      *i = 1;
-    }
+  if (peekToken(tokens)->type == REGISTER) {
+    *rn = nextToken(tokens)->value;
+  } else {
+    throwRegisterError(peekToken(tokens), errorVector, ln);
   }
-  free(token);
 
-  token = peekFront(bracketExpr);
-  if (isShift(token)) {
-    uint32_t aux = *offset;
-    getShift(&bracketExpr, &aux, errorVector, ln);
-    *offset = aux;
+  getOffsetExpr(tokens, offset, i, u, errorVector, ln);
+
+  if (peekToken(tokens)->type == CLOSE_BRACKET) {
+    nextToken(tokens);
+  } else {
+    throwExpressionError(peekToken(tokens), errorVector, ln);
   }
 }
 
-uint32_t decodeSingleDataTransfer(vector *tokens, vector *addresses,
-                uint32_t instructionNumber, uint32_t instructionsNumber,
+uint32_t decodeSingleDataTransfer(tokenList *tokens, literalPool *pool,
+                uint32_t instructionNumber, fixupList *fixups,
                 vector *errorVector, char *ln) {
-  char *instruction = getFront(tokens);
-  char *rdName;
+  token *instruction = nextToken(tokens);
+  token *rdToken;
   uint32_t ins = 1 << 0x1A;
   int i = 0;
   int p = 1;
   int u = 1;
-  int l = !strcmp(instruction, "ldr") ? 1 : 0;
+  int l = mnemonicIs(instruction, "ldr") ? 1 : 0;
   int32_t offset = 0;
   int rn = 0xf; // default rn
   int rd = 0;
-  char *token;
 
-  setCond(&ins, ALWAYS_CONDITION);
+  setCond(&ins, instruction);
 
   if (checkReg(tokens, instruction, errorVector, ln)) {
-    token = getFront(tokens);
-    rd = getDec(token + 1);
-    rdName = token;
+    rdToken = nextToken(tokens);
+    rd = rdToken->value;
   } else {
-    free(instruction);
     return -1;
   }
 
   // check for register or expression
-  token = peekFront(*tokens);
-  if (token && token[0] == '[') {
+  token *t = peekToken(tokens);
+  if (t->type == OPEN_BRACKET) {
     // we have indexed address
     getBracketExpr(tokens, &rn, &offset, &i, &u, errorVector, ln);
 
-    token = peekFront(*tokens);
-
-    if (token) {
-      if (!strcmp(token, "-")) {
-        u = 0;
-        free(token);
-        token = getFront(tokens);
-      } else if (token[0] == '-') {
-        token++;
-        u = 0;
-      }
-
-      if (getType(token) == EXPRESSION_TAG) {
-        // we have post indexed expression
-        token = getFront(tokens);
-        offset = getExpression(token, NULL, 0);
-        free(token);
-        p = 0;
-      } else if (getType(token) == REGISTER) {
-        // we have post indexed register
-        token = getFront(tokens);
-        offset = getDec(token + 1);
-        free(token);
+    if (hasTokens(tokens)) {
+      // we have post indexed expression or register
+      int postI = 0;
+      if (getOffsetExpr(tokens, &offset, &postI, &u, errorVector, ln)) {
         p = 0;
-        i = 1;
-
-        token = peekFront(*tokens);
-        if (isShift(token)) {
-          uint32_t aux = offset;
-          getShift(tokens, &aux, errorVector, ln);
-          offset = aux;
-        }
+        i = postI;
       }
     }
 
@@ -532,34 +1158,48 @@ uint32_t decodeSingleDataTransfer(vector *tokens, vector *addresses,
     }
   } else {
     p = 1;
-    if (getType(token) != EXPRESSION_EQUAL) {
+    if (t->type != EXPRESSION_EQUAL || !l) {
       throwExpressionError(instruction, errorVector, ln);
-      free(rdName);
-      free(instruction);
       return -1;
     }
 
-    if (!strcmp(instruction, "ldr")) {
-      // we have a load instruction
-      if (getType(token) == EXPRESSION_EQUAL) {
-        uint32_t address = getExpression(token, errorVector, ln);
+    // we have a load instruction
+    uint32_t address = t->value;
+    uint32_t chunks[MAX_IMMEDIATE_CHUNKS];
+
+    if (immediateChunks(address, chunks) == 1) {
+      // interpret as move instruction
+      char text[MAX_MNEMONIC_LENGTH];
+      token mov[] = {renameInstruction(instruction, "mov", false, text),
+                     *rdToken};
+      tokenList rewritten = rewriteTokens(mov, 2, tokens);
+      ins = decodeDataProcessing(&rewritten, errorVector, ln);
+      syncRewrittenTokens(tokens, &rewritten, 2);
+      return ins;
+    }
 
-        if (address <= 0xFF) {
-          // interpret as move instruction
-          putFront(tokens, rdName);
-          putFront(tokens, "mov");
-          free(rdName);
-          free(instruction);
-          return decodeDataProcessing(tokens, errorVector, ln);
-        } else {
-          // interpret as normal
-          putBack(addresses, token);
-          int addressLocation = instructionsNumber + addresses->size - 1;
-          offset = (addressLocation - instructionNumber - 2) * MEMORY_SIZE;
-        }
+    // interpret as normal, equal constants share their slot
+    uint32_t slot;
+    if (pool->start == UNPLACED_POOL) {
+      // the offset is filled in once the pool has been placed
+      slot = addLiteral(pool, address);
+      addLiteralFixup(fixups, instructionNumber, slot);
+    } else if (findLiteral(pool, address, &slot)) {
+      // the first pass has already placed the constant
+      offset = literalOffset(instructionNumber, pool->start + slot);
+      if (!literalInRange(offset)) {
+        throwLiteralRangeError(errorVector, ln);
+        offset = 0;
+      } else if (offset < 0) {
+        // the load is right before the pool
+        offset = -offset;
+        u = 0;
       }
-      free(getFront(tokens));
+    } else {
+      // the passes disagree about the constants of the pool
+      throwLiteralMissingError(address, errorVector, ln);
     }
+    nextToken(tokens);
   }
 
   // set bit i 25
@@ -577,252 +1217,100 @@ uint32_t decodeSingleDataTransfer(vector *tokens, vector *addresses,
   // set offset
   ins |= offset;
 
-  free(rdName);
-  free(instruction);
   return ins;
 }
 
-uint32_t decodeBranch(vector *tokens, uint32_t instructionNumber,
-                        map labelMapping, vector *errorVector, char *ln) {
-  char *branch = getFront(tokens);
+uint32_t decodeBranch(tokenList *tokens, uint32_t instructionNumber,
+                        map labelMapping, fixupList *fixups,
+                        vector *errorVector, char *ln) {
+  token *branch = nextToken(tokens);
   uint32_t ins = 0xA << 0x18;
-  setCond(&ins, (branch + 1));
+  setCond(&ins, branch);
   uint32_t *mem;
-  uint32_t target;
+  uint32_t target = 0;
 
-  char *expression = (char *) peekFront(*tokens);
+  token *expression = peekToken(tokens);
 
-  if (!expression || getType(expression) == INSTRUCTION) {
+  if (expression->type == END_OF_LINE || expression->type == INSTRUCTION) {
     throwExpressionMissingError(branch, errorVector, ln);
-    free(branch);
     return -1;
   }
 
-  if ((mem = get(labelMapping, expression))) {
+  if ((mem = getSlice(labelMapping, expression->start, expression->length))) {
     // we have a mapping
-    target = *mem - instructionNumber - PC_OFFSET;
-    target <<= INSTRUCTION_SIZE - (BRANCH_OFFSET_SIZE - 2);
-    target >>= INSTRUCTION_SIZE - (BRANCH_OFFSET_SIZE - 2);
+    target = branchOffset(instructionNumber, *mem);
+  } else if (fixups) {
+    // forward reference, backpatched when the label is defined
+    addBranchFixup(fixups, expression->start, expression->length,
+                   instructionNumber);
+  } else {
+    throwUndefinedLabelError(expression, errorVector, ln);
   }
 
   ins |= target;
-  getFront(tokens);
-  free(branch);
-  free(expression);
+  nextToken(tokens);
   return ins;
 }
 
-uint32_t decodeShift(vector *tokens, vector *errorVector, char *ln) {
-  char *shift = getFront(tokens);
-  char *rn = NULL;
+uint32_t decodeShift(tokenList *tokens, vector *errorVector, char *ln) {
+  token *shift = nextToken(tokens);
 
-  if (checkReg(tokens, shift, errorVector, ln)) {
-    rn = getFront(tokens);
-  }
-
-  if (!rn) {
-    free(shift);
+  if (!checkReg(tokens, shift, errorVector, ln)) {
     return -1;
   }
 
-  // fill front of tokens with mov Rn, Rn, lsl <#expression>
-  putFront(tokens, shift);
-  putFront(tokens, rn);
-  putFront(tokens, rn);
-  putFront(tokens, "mov");
-
-  free(shift);
-  free(rn);
+  token *rn = nextToken(tokens);
+  // rewrite as mov Rn, Rn, <shift> <#expression> with the same suffixes
+  char text[MAX_MNEMONIC_LENGTH];
+  int length = shift->baseLength;
+  token mov[] = {renameInstruction(shift, "mov", true, text), *rn, *rn,
+                 {shift->start, length, SHIFT,
+                  *getSlice(SHIFTS, shift->start, length)}};
+  tokenList rewritten = rewriteTokens(mov, 4, tokens);
+  uint32_t ins = decodeDataProcessing(&rewritten, errorVector, ln);
+  syncRewrittenTokens(tokens, &rewritten, 4);
 
-  return decodeDataProcessing(tokens, errorVector, ln);
+  return ins;
 }
 
-void getShift(vector *tokens, uint32_t *operand,
-                vector *errorVector, char *ln) {
-  char *shift = getFront(tokens);
-  char *token = peekFront(*tokens);
-
-  if (getType(token) != EXPRESSION_TAG && getType(token) != REGISTER) {
-    // throw error
-  }
+void getShift(tokenList *tokens, uint32_t *operand, vector *errorVector,
+              char *ln) {
+  token *shift = nextToken(tokens);
+  token *t = peekToken(tokens);
 
-  if (getType(token) == EXPRESSION_TAG) {
+  if (t->type == EXPRESSION_TAG) {
     // we have expression
-    *operand |= getExpression(token, errorVector, ln) << 0x7;
-  } else {
+    *operand |= t->value << 0x7;
+  } else if (t->type == REGISTER) {
     // we have register
-    *operand |= getDec(token + 1) << 0x8;
+    *operand |= t->value << 0x8;
     // set bit 4
     *operand |= 0x1 << 0x4;
+  } else {
+    throwExpressionMissingError(shift, errorVector, ln);
+    return;
   }
 
-  *operand |= *get(SHIFTS, shift) << 0x5;
+  *operand |= shift->value << 0x5;
 
-  free(getFront(tokens));
-  free(shift);
+  nextToken(tokens);
 }
 
-void setCond(uint32_t *x, char *cond) {
-  uint32_t condition = *get(CONDITIONS, cond) << 0x1C;
+void setCond(uint32_t *x, const token *instruction) {
+  uint32_t condition = conditionCode(instruction) << 0x1C;
   // make space
   *x <<= 4;
   *x >>= 4;
   *x |= condition;
 }
 
-vector tokenise(char *start, char *delimiters) {
-  int tokenSize = 0;
-  int i;
-  vector tokens = constructVector();
-
-  for (i = 0; start[i] != '\0'; i++) {
-    tokenSize++;
-
-    if (strchr(delimiters, start[i])) {
-      // found delimiter add token to vector
-      tokenSize--;
-      if (tokenSize) {
-        // make sapce for token string
-        char *token = malloc((tokenSize + 1) * sizeof(char));
-        strncpy(token, start + i - tokenSize, tokenSize);
-        token[tokenSize] = '\0';
-        putBack(&tokens, token);
-        tokenSize = 0;
-        free(token);
-      }
-    }
-  }
-
-  if (tokenSize) {
-    // we still have one token left
-    char *token = malloc((tokenSize + 1) * sizeof(char));
-    strncpy(token, start + i - tokenSize, tokenSize);
-    token[tokenSize] = '\0';
-    putBack(&tokens, token);
-    free(token);
-  }
-
-  return tokens;
-}
-
-bool isRegister(char *token) {
-  int length  = strlen(token);
-
-  if (length < 2 || length > 3 || token[0] != 'r') {
-    return false;
-  }
-
-  for (int i = 1; i < length; i++) {
-    if (token[i] < '0' || token[i] > '9') {
-      return false;
-    }
-  }
-
-  int number  = atoi(token + 1);
-  return number >= 0 && number <= 16;
-}
-
-bool isLabel(char *token) {
-  return token[strlen(token) - 1] == ':';
-}
-
-typeEnum isExpression(char *token) {
-  if (!strlen(token)) {
-    return UNDEFINED;
-  }
-
-  if (token[0] != '#' && token[0] != '=') {
-    return UNDEFINED;
-  }
-
-  int i = 1;
-  if (token[i] == '-') {
-    i++;
-  }
-
-  if (strlen(token) >= i + 3 && token[i] == '0' &&token[i + 1] == 'x') {
-    // we might have a hex value
-    i += 2;
-
-    for (; token[i] != '\0'; i++) {
-      if ((token[i] < '0' || token[i] > '9') &&
-          (token[i] < 'a' || token[i] > 'f') &&
-          (token[i] < 'A' || token[i] > 'F')) {
-        return UNDEFINED;
-      }
-    }
-  } else {
-    // we might have a decimal value
-
-    if (token[i] == '\0') {
-      return UNDEFINED;
-    }
-
-    for (int i = 1; token[i] != '\0'; i++) {
-      if (token[i] < '0' || token[i] > '9') {
-        return UNDEFINED;
-      }
-    }
-  }
-
-  return token[0] == '#' ? EXPRESSION_TAG : EXPRESSION_EQUAL;
-}
-
-bool isInstruction(char *token) {
-  return get(ALL_INSTRUCTIONS, token);
-}
-
-bool isShift(char *token) {
-  if (!token) {
-    return false;
-  }
-
-  return get(SHIFTS, token);
-}
-
-typeEnum getType(char *token) {
-  if (!token) {
-    return UNDEFINED;
-  }
-
-  if (isLabel(token)) {
-    return LABEL;
-  }
-
-  if (isExpression(token) != UNDEFINED) {
-    return isExpression(token);
-  }
-
-  if (isInstruction(token)) {
-    return INSTRUCTION;
-  }
-
-  if (isRegister(token)) {
-    return REGISTER;
-  }
-
-  return UNDEFINED;
-}
-
-int32_t getExpression(char *exp, vector *errorVector, char *ln) {
-  uint32_t res = 0;
+int32_t getExpression(const token *exp, vector *errorVector, char *ln) {
+  uint32_t res = exp->value;
   uint32_t rotations = 0;
 
-  int i = 1;
-
-  if (exp[i] == '-') {
-    i++;
-  }
-
-  if (exp[i] == '0' && exp[i + 1] == 'x') {
-    res = getHex(exp + 1);
-  } else {
-    res = getDec(exp + 1);
-  }
-
-  if (exp[0] == '#') {
+  if (exp->type == EXPRESSION_TAG || exp->type == EXPRESSION_EQUAL) {
     // check if exp can be roatated to a 8 bit imediate value
-    while (abs(res) >= 0x100 && rotations <= 30) {
+    while (res >= 0x100 && rotations <= 30) {
       char bits31_30 = (res & 0xC0000000) >> (INSTRUCTION_SIZE - 2);
       res <<= 2;
       res |= bits31_30;
@@ -842,35 +1330,7 @@ int32_t getExpression(char *exp, vector *errorVector, char *ln) {
   return res;
 }
 
-int32_t getHex(char *exp) {
-  int32_t res = 0;
-  bool negative = false;
-  if (exp[0] == '-') {
-    negative = true;
-    exp++;
-  }
-  exp += 2;
-  for (int i = 0; exp[i] != '\0'; i++) {
-    int x;
-    if (exp[i] >= 'A' && exp[i] <= 'F') {
-      x = exp[i] - 'A' + 10;
-    } else if (exp[i] >= 'a' && exp[i] <= 'f') {
-      x = exp[i] - 'a' + 10;
-    } else {
-      x = exp[i] - '0';
-    }
-    res <<= 4;
-    res |= x;
-  }
-
-  return negative ? -res : res;
-}
-
-int32_t getDec(char *exp) {
-  return atoi(exp);
-}
-
-char *uintToString(uint32_t num) {
+char *uintToString(arena *pool, uint32_t num) {
   int n = num;
   int length = 0;
 
@@ -879,7 +1339,7 @@ char *uintToString(uint32_t num) {
     n /= 10;
   } while (n != 0);
 
-  char *ret = malloc((length + 1) * sizeof(char));
+  char *ret = arenaAlloc(pool, (length + 1) * sizeof(char));
 
   for (int i = 0; i < length; i++) {
     ret[length - i - 1] = num % 10 + '0';
@@ -891,67 +1351,74 @@ char *uintToString(uint32_t num) {
   return ret;
 }
 
-void clearLinesFromFile(char **linesFromFile) {
-  for(int i = 0; i < (countDynamicExpansions * NUMBER_OF_LINES); i++) {
-    free(linesFromFile[i]);
-  }
-  free(linesFromFile);
-}
-
 // ----------------------ERRORS--------------------------------
-void throwUndefinedError(char *name, vector *errorVector, char *ln) {
-  char *error = malloc(200);
-  strcpy(error, "[");
-  strcat(error, ln);
-  strcat(error, "] Undefined instruction ");
-  strcat(error, name);
-  strcat(error, ".");
+void throwError(vector *errorVector, char *ln, const char *format, ...) {
+  char error[MAX_ERROR_LENGTH];
+  int length = snprintf(error, MAX_ERROR_LENGTH, "[%s] ", ln);
+  va_list args;
+
+  va_start(args, format);
+  vsnprintf(error + length, MAX_ERROR_LENGTH - length, format, args);
+  va_end(args);
+
   putBack(errorVector, error);
-  free(error);
 }
 
-void throwLabelError(char *name, vector *errorVector, char *ln) {
-  char *error = malloc(200);
-  strcpy(error, "[");
-  strcat(error, ln);
-  strcat(error, "] Multiple definitions of the same label: ");
-  strcat(error, name);
-  strcat(error, ".");
+void throwFileError(vector *errorVector, const char *format,
+                    const char *path) {
+  char error[MAX_ERROR_LENGTH];
+
+  snprintf(error, MAX_ERROR_LENGTH, format, path);
   putBack(errorVector, error);
-  free(error);
 }
 
-void throwExpressionError(char *name, vector *errorVector, char *ln) {
-  char *error = malloc(200);
-  strcpy(error, "[");
-  strcat(error, ln);
-  strcat(error, "] The expression ");
-  strcat(error, name);
-  strcat(error, " is invalid.");
-  putBack(errorVector, error);
-  free(error);
+void throwUndefinedError(const token *name, vector *errorVector, char *ln) {
+  throwError(errorVector, ln, "Undefined instruction %.*s.",
+             name->length, name->start);
 }
 
-void throwRegisterError(char *name, vector *errorVector, char *ln) {
-  char *error = malloc(200);
-  strcpy(error, "[");
-  strcat(error, ln);
-  strcat(error, "] The register ");
-  strcat(error, name);
-  strcat(error, " is invalid.");
-  putBack(errorVector, error);
-  free(error);
+void throwLabelError(const token *name, vector *errorVector, char *ln) {
+  throwError(errorVector, ln, "Multiple definitions of the same label: %.*s.",
+             name->length - 1, name->start);
 }
 
-void throwExpressionMissingError(char *ins, vector *errorVector, char *ln) {
-  char *error = malloc(200);
-  strcpy(error, "[");
-  strcat(error, ln);
-  strcat(error, "] The expression is missing from the ");
-  strcat(error, ins);
-  strcat(error, " instruction.");
-  putBack(errorVector, error);
-  free(error);
+void throwUndefinedLabelError(const token *name, vector *errorVector,
+                              char *ln) {
+  throwError(errorVector, ln, "Undefined label %.*s.",
+             name->length, name->start);
+}
+
+void throwLiteralRangeError(vector *errorVector, char *ln) {
+  throwError(errorVector, ln, "The literal pool is out of range of the load.");
+}
+
+void throwLiteralMissingError(uint32_t value, vector *errorVector, char *ln) {
+  throwError(errorVector, ln,
+             "Internal error: the constant 0x%x has no literal pool slot.",
+             value);
+}
+
+void throwExpressionError(const token *name, vector *errorVector, char *ln) {
+  throwError(errorVector, ln, "The expression %.*s is invalid.",
+             name->length, name->start);
+}
+
+void throwRegisterError(const token *name, vector *errorVector, char *ln) {
+  throwError(errorVector, ln, "The register %.*s is invalid.",
+             name->length, name->start);
+}
+
+void throwExpressionMissingError(const token *ins, vector *errorVector,
+                                 char *ln) {
+  throwError(errorVector, ln,
+             "The expression is missing from the %.*s instruction.",
+             ins->length, ins->start);
+}
+
+void throwGlobalMissingError(const token *directive, vector *errorVector,
+                             char *ln) {
+  throwError(errorVector, ln, "The label is missing from the %.*s directive.",
+             directive->length, directive->start);
 }
 
 // -----------------------DEBUGGING---------------------------
@@ -970,9 +1437,3 @@ void printBinary(uint32_t nr) {
 
   putchar('\n');
 }
-
-void printStringArray(int n, char arr[][MAX_LINE_LENGTH]) {
-  for (int i = 0; i < n; i++) {
-    printf("%s", arr[i]);
-  }
-}
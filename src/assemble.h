@@ -1,129 +1,379 @@
-#include "mappings.h"
+#include "lexer.h"
+#include "source.h"
+#include "fixup.h"
+#include "workers.h"
+#include "linecache.h"
+#include "object.h"
+#include "literals.h"
+#include "optimise.h"
+#include "probes.h"
+#include <stdarg.h>
 
 // ---------------------------MACROS-----------------------------
-#define MAX_LINE_LENGTH 512
-#define DELIMITERS " ,\n"
-#define MEMORY_SIZE 4
-#define PC_OFFSET 2
-#define INSTRUCTION_SIZE 32
-#define ALWAYS_CONDITION ""
-#define BRANCH_OFFSET_SIZE  26
-#define NUMBER_OF_LINES 1000
-
-// --------------------GLOBAL VARIABLES--------------------------
-int countDynamicExpansions = 1;
+#define MAX_ERROR_LENGTH 200
+#define PASS_CHUNK_LINES 16384
+#define CHUNKS_PER_WORKER 4
+#define CACHE_SUFFIX ".cache"
+#define MAX_IMMEDIATE_CHUNKS 4
+// cost of a constant: every instruction of a mov/orr sequence is a word and
+// a cycle, a literal load is a word and about 4 cycles until the loaded
+// value can be used (ARM1176) plus one pool word shared by all the loads of
+// the constant. Ties go to the pool
+#define SEQUENCE_INSTRUCTION_COST 2
+#define LITERAL_LOAD_COST 5
+
+// -------------------------TYPES---------------------------------
+typedef struct assembleOptions assembleOptions;
+typedef struct passChunk passChunk;
+typedef struct assembleJob assembleJob;
+typedef struct encodingCache encodingCache;
+
+// -------------------------STRUCTS-------------------------------
+/**
+* Command line options of the assembler:
+* -s, --single-pass  read the source once and backpatch forward references
+* -jN, --jobs=N      encode the second pass on N threads, or assemble N files
+*                    at once when given many files
+* --manifest=FILE    assemble every input:output pair listed in FILE
+* --cache[=FILE]     reuse the encodings of the lines which haven't changed
+*                    since the last run, kept in FILE (by default the output
+*                    file followed by CACHE_SUFFIX)
+* -c, --object       write a relocatable object for link instead of a binary
+* -O                 remove the redundant instructions once the program is
+*                    encoded (see optimiseProgram)
+* --symbols[=FILE]   write the address of every label to FILE (by default
+*                    the output file followed by SYMBOL_SUFFIX) for the
+*                    profiler of the emulator
+**/
+struct assembleOptions {
+  bool singlePass;
+  int  jobs;
+  char *manifest;
+  char *cache;
+  bool object;
+  bool optimise;
+  char *symbols;
+};
+
+/**
+* previous holds the encodings of the last run and is only read, the
+* encodings of this run are added to current which is saved for the next one
+**/
+struct encodingCache {
+  const lineCache *previous;
+  lineCache       current;
+};
+
+/**
+* One file of a batch: pair is the input:output argument split in input and
+* output. Everything the file allocates, errors included, lives in pool
+**/
+struct assembleJob {
+  char                  *pair;
+  char                  *input;
+  char                  *output;
+  const assembleOptions *options;
+  arena                 pool;
+  vector                errors;
+  bool                  assembled;
+};
+
+/**
+* Lines [firstLine, lastLine) encoded by one job of the parallel second pass
+* The chunk starts at the address words.base and its literals go to the
+* pool firstPool of pools. source, labelMapping and pools are only read
+**/
+struct passChunk {
+  sourceFile    *source;
+  map           *labelMapping;
+  literalPools  *pools;
+  uint32_t      firstLine;
+  uint32_t      lastLine;
+  int           firstPool;
+  outputWriter  words;
+  vector        errors;
+  arena         pool;
+  encodingCache cache;
+};
 
 // -------------------FUNCTION DECLARATIONS-----------------------
+/* Sets the option in options, returns false if the option is unknown */
+bool parseOption(char *option, assembleOptions *options);
+
+/**
+* Assembles inputPath to outputPath, all the errors are added to errorVector
+* and nothing is written to outputPath if there are any
+* Everything which lives until the file is assembled is allocated from pool
+* Returns true iff the file was assembled
+**/
+bool assembleFile(const char *inputPath, const char *outputPath,
+                  const assembleOptions *options, vector *errorVector,
+                  arena *pool);
+
+/**
+* Assembles the count input:output pairs and the ones of the manifest on
+* options->jobs threads. The mnemonic maps are filled once and only read by
+* the threads. The errors are printed in the order of the files, prefixed
+* with the input file
+* Returns true iff all the files were assembled
+**/
+bool assembleBatch(int count, char **pairs, const assembleOptions *options);
+
+/* Job of the worker pool which assembles one assembleJob */
+void assembleJobFile(void *job);
+
+/**
+* Adds every input:output pair of the manifest at path to pairs, one pair
+* per line. Empty lines and lines starting with COMMENT_START are skipped
+* Returns false if the manifest can't be read
+**/
+bool readManifest(const char *path, vector *pairs);
+
+/**
+* Splits pair at the first ':' or blank in input and output
+* Returns false if pair is not of the form input:output
+**/
+bool splitPair(char *pair, char **input, char **output);
+
+/**
+* Returns the path of a file kept next to outputPath (the cache or the
+* symbols), which is path itself unless it is empty, then it is outputPath
+* followed by suffix. The path is allocated from pool
+**/
+char *sidecarFile(const char *path, const char *outputPath,
+                  const char *suffix, arena *pool);
+
 // -----------------------FILE PASSES-----------------------------
 /**
-* Returns a char array that contains all the program lines
 * Maps all labels with their respective memory location
-* Finds the number of the instructions and returns it through instructionsNumber
-* Finds the number of ldr instructions and returns it through ldrCount
-* Finds the number of lines and returns it through lineNumber
+* Fills the literal pools: every constant of a ldr which doesn't fit in a
+* mov gets a single slot in the next pool, every .ltorg places a pool and
+* the last pool starts at the end of the program
 * Throws any errors occour during the first pass such as multiple definitions
 * of the same label
+* If chunkStarts is not NULL the address and the pool of the first line of
+* every PASS_CHUNK_LINES lines are appended to it
+* Every label named by a .global directive is mapped in exports to the line
+* of the directive
+* Pending labels are allocated from pool
+**/
+void firstPass(sourceFile *source, map *labelMapping, vector *errorVector,
+               literalPools *pools, array *chunkStarts, map *exports,
+               arena *pool);
+
+/**
+* Consumes a .global directive and the label it names
+* Throws an error if the label is missing
+**/
+void skipGlobal(tokenList *tokens, vector *errorVector, char *ln);
+
+/* Returns true iff the instruction is a ldr which needs a literal pool slot */
+bool usesLiteralPool(const token *instruction, tokenList *operands);
+
+// ---------------------------CONSTANTS---------------------------
+/**
+* Splits value in the fewest 8 bit windows at even positions, each of which
+* is a rotated immediate, and returns them through chunks
+* Returns the number of windows or more than MAX_IMMEDIATE_CHUNKS if the
+* value can't be split in MAX_IMMEDIATE_CHUNKS windows
+**/
+int immediateChunks(uint32_t value, uint32_t chunks[MAX_IMMEDIATE_CHUNKS]);
+
+/**
+* Returns true iff loading value from the literal pool costs no more than
+* building it with a mov/orr sequence, however many times it is loaded
+**/
+bool prefersLiteral(uint32_t value);
+
+/**
+* Returns the number of instructions of the mov/orr sequence the instruction
+* at index instruction of tokens is synthesised as, or 0 if it is encoded
+* as usual. A mov of a constant which isn't a rotated immediate is always
+* synthesised, a ldr of a constant only when it's strictly cheaper than a
+* load
 **/
-char **firstPass(FILE *input, map *labelMapping, vector *errorVector,
-        uint32_t *instructionsNumber, uint32_t *ldrCount, uint32_t *lineNumber);
+int sequenceLength(const tokenList *tokens, int instruction,
+                   uint32_t chunks[MAX_IMMEDIATE_CHUNKS]);
 
 /**
-* Fills the instrcutions array with all the decode instrcutions
+* Encodes the instruction at the current token as a mov/orr sequence in
+* words if sequenceLength says so
+* Returns the number of words of the sequence, 0 if nothing was encoded
+**/
+int synthesiseConstant(tokenList *tokens, uint32_t words[MAX_IMMEDIATE_CHUNKS],
+                       vector *errorVector, char *ln);
+
+/**
+* Writes all the decoded instrcutions and the pools filled by the first
+* pass to output
 * Throws any errors encountered during the pass
+* Everything allocated for a line lives in a scratch arena which is reset
+* after each line
+**/
+void secondPass(literalPools *pools, outputWriter *output,
+                vector *errorVector, map labelMapping, sourceFile *source,
+                encodingCache *cache);
+
+/* Appends the constants of the pool to output */
+void emitPool(outputWriter *output, fixupList *fixups,
+              const literalPool *pool);
+
+/**
+* Encodes the lines [firstLine, lastLine) to output, the literals are loaded
+* from the pools of pools starting with the pool poolIndex
+* If cache is not NULL the lines found in cache->previous are not decoded
+* and the encoding of every line is added to cache->current
+* If fixups is not NULL the loads from an unplaced pool and the branches to
+* undefined labels are added to it instead of being encoded
+**/
+void encodeLines(sourceFile *source, uint32_t firstLine, uint32_t lastLine,
+                 literalPools *pools, int poolIndex, outputWriter *output,
+                 map labelMapping, vector *errorVector, encodingCache *cache,
+                 fixupList *fixups);
+
+/**
+* Computes the cache key of the instruction at the current token: the text
+* from the instruction to the end of the line and the distance to the label
+* or literal pool slot it refers to
+* Returns false if the instruction can't be cached (eg. undefined label)
+**/
+bool instructionKey(tokenList *tokens, uint32_t instructionNumber,
+                    const literalPool *pool, map labelMapping,
+                    uint64_t *key);
+
+/**
+* Same as secondPass but the lines are split in chunks which are encoded by
+* jobs threads. Every chunk knows from chunkStarts where its instructions
+* start and which pool its literals go to, so the output is the same as
+* secondPass
+**/
+void parallelSecondPass(literalPools *pools, outputWriter *output,
+              vector *errorVector, map labelMapping, sourceFile *source,
+              array *chunkStarts, int jobs, encodingCache *cache);
+
+/* Job of the parallel second pass which encodes one passChunk */
+void encodeChunk(void *job);
+
+/**
+* Second pass which assembles the source to a relocatable object: the code
+* is kept in output, which must keep all its words, and the exported labels,
+* the last literal pool and the relocations are added to object
+* Throws an error for every exported label which isn't defined
+**/
+void objectPass(outputWriter *output, vector *errorVector, map labelMapping,
+                map exports, sourceFile *source, literalPools *pools,
+                objectFile *object, arena *pool);
+
+/**
+* Assembles the source reading it only once: labels are mapped as they are
+* defined, branches to labels which aren't defined yet and literal loads are
+* recorded as fixups and backpatched once the label or the pool (at the
+* next .ltorg or at the end) is placed
+* Throws an error for every label which is never defined
+**/
+void singlePass(sourceFile *source, outputWriter *output, vector *errorVector,
+                map *labelMapping, arena *pool);
+/**
+* Appends the word to the output. When the window of the output is full the
+* words which no pending fixup can reach are flushed first
 **/
-void secondPass(uint32_t *instructionsNumber, uint32_t instructions[],
-              vector *errorVector, map labelMapping,
-              char** linesFromFile, uint32_t lineNumber);
+void emitInstruction(outputWriter *output, fixupList *fixups, uint32_t word);
+
 // --------------------DECODING FUNCTIONS-------------------------
-/* Main decode function which returns the decoded instruction */
-uint32_t decode(vector *tokens, vector *addresses, uint32_t instructionNumber,
-  uint32_t instructionsNumber, map labelMapping, vector *errorVector, char *ln);
+/**
+* Main decode function which returns the decoded instruction
+* If fixups is not NULL, forward references and literal loads are recorded
+* in it instead of being encoded
+**/
+uint32_t decode(tokenList *tokens, literalPool *pool,
+                uint32_t instructionNumber, map labelMapping,
+                fixupList *fixups, vector *errorVector, char *ln);
 
 /* Decodes any Data Processing Instruction */
-uint32_t decodeDataProcessing(vector *tokens, vector *errorVector, char *ln);
+uint32_t decodeDataProcessing(tokenList *tokens, vector *errorVector,
+                              char *ln);
 
 /* Decodes any Multiply Instruction */
-uint32_t decodeMultiply(vector *tokens, vector *errorVector, char *ln);
+uint32_t decodeMultiply(tokenList *tokens, vector *errorVector, char *ln);
 
-/* Decodes any Single Data Transfer Instruction */
-uint32_t decodeSingleDataTransfer(vector *tokens, vector *addresses,
-                uint32_t instructionNumber, uint32_t instructionsNumber,
+/**
+* Decodes any Single Data Transfer Instruction, the constant of a literal
+* load is taken from pool. If the pool isn't placed yet the constant is
+* added to it and the load is recorded in fixups
+**/
+uint32_t decodeSingleDataTransfer(tokenList *tokens, literalPool *pool,
+                uint32_t instructionNumber, fixupList *fixups,
                 vector *errorVector, char *ln);
 
 /* Decodes any Branch Instruction */
-uint32_t decodeBranch(vector *tokens, uint32_t instructionNumber,
-                map labelMapping, vector *errorVector, char *ln);
+uint32_t decodeBranch(tokenList *tokens, uint32_t instructionNumber,
+                map labelMapping, fixupList *fixups,
+                vector *errorVector, char *ln);
 
 /* Decodes any Shift Instruction */
-uint32_t decodeShift(vector *tokens, vector *errorVector, char *ln);
-
-/**
-* Creates a vector with all of the tokens of the original string
-* without modifing it with respect to the delimiters (eg. " ,.")
-**/
-vector tokenise(char *start, char *delimiters);
-
-// ---------------------TYPE FUNCTIONS-------------------------
-/* Returns the type of the passed token */
-typeEnum getType(char *token);
-
-/* Helpers for type */
-bool isInstruction(char *token);
-bool isLabel(char *token);
-bool isRegister(char *token);
-bool isShift(char *token);
-typeEnum isExpression(char *token);
+uint32_t decodeShift(tokenList *tokens, vector *errorVector, char *ln);
 
 // ----------------------GET FUNCTIONS-------------------------
 /* Gets the shift type and applays the shift rules to the operand parameter */
-void getShift(vector *tokens, uint32_t *operand, vector *errorVector, char *ln);
+void getShift(tokenList *tokens, uint32_t *operand, vector *errorVector,
+              char *ln);
 
 /**
 * Gets expressions of the type [register], [register, register],
 * [register, register, shift] (everything that is related to memory access)
 **/
-void getBracketExpr(vector *tokens, int *rn, int32_t *offset, int *i, int *u,
-                    vector *errorVector, char *ln);
+void getBracketExpr(tokenList *tokens, int *rn, int32_t *offset, int *i,
+                    int *u, vector *errorVector, char *ln);
+
+/**
+* Gets the offset of a memory access: [-]<#expression> or
+* [-]register [shift]. Returns false if there is no offset
+**/
+bool getOffsetExpr(tokenList *tokens, int32_t *offset, int *i, int *u,
+                   vector *errorVector, char *ln);
+
 /**
 * Gets expression of type <#expression> or <=expression> and throws errors
 * if the value in the exp can't be represented
 **/
-int32_t getExpression(char *exp, vector *errorVector, char *ln);
-
-/* Gets hexadecimal value from string */
-int32_t getHex(char *exp);
-
-/* Gets decimal value from string */
-int32_t getDec(char *exp);
-
-/* Clears the vector tokens if the token '@' is found (i.e. a comment) */
-void getComment(vector *tokens);
+int32_t getExpression(const token *exp, vector *errorVector, char *ln);
 
 // ------------------------HELPERS-------------------------------
-/* Converts unsigned int to string */
-char *uintToString(uint32_t num);
+/* Converts unsigned int to string allocated from pool */
+char *uintToString(arena *pool, uint32_t num);
 
 /* Checks format of registers and throws error if the format is invalid */
-bool checkReg(vector *tokens, char *instr,
+bool checkReg(tokenList *tokens, const token *instr,
                 vector *errorVector, char *ln);
 
-/* Sets the cond field of the instruction */
-void setCond(uint32_t *x, char *cond);
-
-/* Frees the matrix of lines */
-void clearLinesFromFile(char **linesFromFile);
+/* Sets the cond field of x to the condition suffix of instruction */
+void setCond(uint32_t *x, const token *instruction);
 
 // ----------------------ERRORS--------------------------------
 /**
 * All of the error functions append an error message to the errorVector
 * which will be printed at the end of the program if there are any errors
 **/
-void throwUndefinedError(char *name, vector *errorVector, char *ln);
-void throwLabelError(char *name, vector *errorVector, char *ln);
-void throwExpressionError(char *expression, vector *errorVector, char *ln);
-void throwRegisterError(char *name, vector *errorVector, char *ln);
-void throwExpressionMissingError(char *ins, vector *errorVector, char *ln);
+void throwUndefinedError(const token *name, vector *errorVector, char *ln);
+void throwLabelError(const token *name, vector *errorVector, char *ln);
+void throwUndefinedLabelError(const token *name, vector *errorVector,
+                              char *ln);
+void throwLiteralRangeError(vector *errorVector, char *ln);
+void throwLiteralMissingError(uint32_t value, vector *errorVector, char *ln);
+void throwExpressionError(const token *expression, vector *errorVector,
+                          char *ln);
+void throwRegisterError(const token *name, vector *errorVector, char *ln);
+void throwExpressionMissingError(const token *ins, vector *errorVector,
+                                 char *ln);
+void throwGlobalMissingError(const token *directive, vector *errorVector,
+                             char *ln);
+
+/* Appends "[ln] <message>" to the errorVector */
+void throwError(vector *errorVector, char *ln, const char *format, ...);
+
+/* Adds format filled in with path to the errors, for errors about a file */
+void throwFileError(vector *errorVector, const char *format,
+                    const char *path);
 
 // -----------------------DEBUGGING---------------------------
-void printStringArray(int n, char arr[][MAX_LINE_LENGTH]);
 void printBinary(uint32_t nr);
@@ -0,0 +1,316 @@
+#include "cache.h"
+
+static const char *POLICY_NAMES[] = {"random", "rr", "lru", "fifo"};
+
+//--------------Configuration--------------------------------------------------
+static bool isPowerOf2(int value) {
+  return value > 0 && !(value & (value - 1));
+}
+
+/* Reads a number, of bytes with an optional k suffix, up to the next ',' */
+static bool parseNumber(const char *text, int *number, int minimum) {
+  char *end;
+  long value = strtol(text, &end, 10);
+  if (*end == 'k' || *end == 'K') {
+    value *= 1024;
+    end++;
+  }
+  if (end == text || (*end && *end != ',') || value < minimum ||
+      value > MEM_SIZE_WORDS * 4) {
+    return false;
+  }
+  *number = value;
+  return true;
+}
+
+bool parseCacheConfig(const char *spec, cache_config_t *config) {
+  while (*spec) {
+    const char *value = strchr(spec, '=');
+    if (!value) {
+      return false;
+    }
+    value++;
+    int length = value - spec;
+    bool valid;
+    if (!strncmp(spec, "size=", length)) {
+      valid = parseNumber(value, &config->size, 1);
+    } else if (!strncmp(spec, "ways=", length)) {
+      valid = parseNumber(value, &config->ways, 1);
+    } else if (!strncmp(spec, "line=", length)) {
+      valid = parseNumber(value, &config->line, 1);
+    } else if (!strncmp(spec, "tlb=", length)) {
+      valid = parseNumber(value, &config->tlbEntries, 0);
+    } else if (!strncmp(spec, "policy=", length)) {
+      valid = false;
+      for (int i = 0; i <= REPLACE_FIFO; i++) {
+        int nameLength = strlen(POLICY_NAMES[i]);
+        if (!strncmp(value, POLICY_NAMES[i], nameLength) &&
+            (!value[nameLength] || value[nameLength] == ',')) {
+          config->policy = i;
+          valid = true;
+        }
+      }
+    } else {
+      return false;
+    }
+    if (!valid) {
+      return false;
+    }
+    spec = strchr(value, ',') ? strchr(value, ',') + 1 : value + strlen(value);
+  }
+
+  return isPowerOf2(config->line) && config->line >= 4 &&
+         config->ways <= MAX_CACHE_WAYS &&
+         config->tlbEntries <= MAX_TLB_ENTRIES &&
+         config->size % (config->ways * config->line) == 0 &&
+         isPowerOf2(config->size / (config->ways * config->line));
+}
+
+//--------------Caches---------------------------------------------------------
+static void constructCache(cache_t *cache, cache_config_t config) {
+  cache->config = config;
+  cache->sets = config.size / (config.ways * config.line);
+  int lines = cache->sets * config.ways;
+  cache->tags = calloc(lines, sizeof(uint32_t));
+  cache->valid = calloc(lines, sizeof(bool));
+  cache->stamps = calloc(lines, sizeof(uint64_t));
+  cache->victims = calloc(cache->sets, sizeof(int));
+  if (!cache->tags || !cache->valid || !cache->stamps || !cache->victims) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  cache->random = RANDOM_SEED;
+}
+
+static void clearCache(cache_t *cache) {
+  free(cache->tags);
+  free(cache->valid);
+  free(cache->stamps);
+  free(cache->victims);
+}
+
+/* Returns the way of set to replace, an invalid one first */
+static int victimOf(cache_t *cache, int set) {
+  int ways = cache->config.ways;
+  int first = set * ways;
+  for (int way = 0; way < ways; way++) {
+    if (!cache->valid[first + way]) {
+      return way;
+    }
+  }
+
+  switch (cache->config.policy) {
+    case REPLACE_RANDOM:
+      //xorshift, the same victims on every run
+      cache->random ^= cache->random << 13;
+      cache->random ^= cache->random >> 17;
+      cache->random ^= cache->random << 5;
+      return cache->random % ways;
+    case REPLACE_ROUND_ROBIN: {
+      int way = cache->victims[set];
+      cache->victims[set] = (way + 1) % ways;
+      return way;
+    }
+    default: {
+      //the oldest access for LRU, the oldest fill for FIFO
+      int oldest = 0;
+      for (int way = 1; way < ways; way++) {
+        if (cache->stamps[first + way] < cache->stamps[first + oldest]) {
+          oldest = way;
+        }
+      }
+      return oldest;
+    }
+  }
+}
+
+/* Looks up the line of address and fills it on a miss */
+static bool lookup(cache_t *cache, uint32_t address) {
+  uint32_t line = address / cache->config.line;
+  int set = line % cache->sets;
+  uint32_t tag = line / cache->sets;
+  int first = set * cache->config.ways;
+  cache->time++;
+
+  for (int way = 0; way < cache->config.ways; way++) {
+    if (cache->valid[first + way] && cache->tags[first + way] == tag) {
+      if (cache->config.policy == REPLACE_LRU) {
+        cache->stamps[first + way] = cache->time;
+      }
+      cache->hits++;
+      return true;
+    }
+  }
+
+  int victim = first + victimOf(cache, set);
+  cache->valid[victim] = true;
+  cache->tags[victim] = tag;
+  cache->stamps[victim] = cache->time;
+  cache->misses++;
+  return false;
+}
+
+static void lookupTlb(tlb_t *tlb, uint32_t address) {
+  if (!tlb->entries) {
+    return;
+  }
+  uint32_t page = address / TLB_PAGE_SIZE;
+  int oldest = 0;
+  tlb->time++;
+  for (int i = 0; i < tlb->used; i++) {
+    if (tlb->pages[i] == page) {
+      tlb->stamps[i] = tlb->time;
+      tlb->hits++;
+      return;
+    }
+    if (tlb->stamps[i] < tlb->stamps[oldest]) {
+      oldest = i;
+    }
+  }
+
+  int entry = tlb->used < tlb->entries ? tlb->used++ : oldest;
+  tlb->pages[entry] = page;
+  tlb->stamps[entry] = tlb->time;
+  tlb->misses++;
+}
+
+cache_sim_t *createCacheSim(cache_config_t config) {
+  cache_sim_t *sim = calloc(1, sizeof(cache_sim_t));
+  if (!sim) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  constructCache(&sim->instruction, config);
+  constructCache(&sim->data, config);
+  sim->instructionTlb.entries = config.tlbEntries;
+  sim->dataTlb.entries = config.tlbEntries;
+  return sim;
+}
+
+void destroyCacheSim(cache_sim_t *sim) {
+  clearCache(&sim->instruction);
+  clearCache(&sim->data);
+  free(sim);
+}
+
+bool cacheFetch(cache_sim_t *sim, int address) {
+  lookupTlb(&sim->instructionTlb, address);
+  bool hit = lookup(&sim->instruction, address);
+  if (address >= 0 && address / 4 < MEM_SIZE_WORDS) {
+    sim->fetches[address / 4]++;
+    sim->fetchMisses[address / 4] += !hit;
+  }
+  return hit;
+}
+
+bool cacheAccess(cache_sim_t *sim, int address, int pc) {
+  lookupTlb(&sim->dataTlb, address);
+  bool hit = lookup(&sim->data, address);
+  //an unaligned word can straddle two lines
+  int line = sim->data.config.line;
+  if ((address + 3) / line != address / line) {
+    hit &= lookup(&sim->data, address + 3);
+  }
+  if (pc >= 0 && pc / 4 < MEM_SIZE_WORDS) {
+    sim->accesses[pc / 4]++;
+    sim->accessMisses[pc / 4] += !hit;
+  }
+  return hit;
+}
+
+//--------------Report---------------------------------------------------------
+static int compareMisses(const void *a, const void *b) {
+  const cache_counts_t *x = a;
+  const cache_counts_t *y = b;
+  uint64_t missesX = x->fetchMisses + x->accessMisses;
+  uint64_t missesY = y->fetchMisses + y->accessMisses;
+  if (missesX != missesY) {
+    return missesX > missesY ? -1 : 1;
+  }
+  return x->address < y->address ? -1 : x->address > y->address;
+}
+
+static double missRate(uint64_t misses, uint64_t total) {
+  return total ? 100.0 * misses / total : 0.0;
+}
+
+static void printTotals(const char *name, uint64_t hits, uint64_t misses,
+                        FILE *out) {
+  fprintf(out, "%-16s %12" PRIu64 " hits %12" PRIu64 " misses %6.2f%%\n",
+          name, hits, misses, missRate(misses, hits + misses));
+}
+
+void printCacheSim(cache_sim_t *sim, profile_t *symbols, FILE *out) {
+  cache_config_t *config = &sim->data.config;
+  cache_counts_t *entries = malloc(MEM_SIZE_WORDS * sizeof(cache_counts_t));
+  //indexed by the label + 1 like in printProfile
+  cache_counts_t *labels = calloc(symbols->symbolCount + 1,
+                                  sizeof(cache_counts_t));
+  if (!entries || !labels) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+
+  fprintf(out, "Caches: %d bytes, %d ways, %d byte lines, %s replacement\n",
+          config->size, config->ways, config->line,
+          POLICY_NAMES[config->policy]);
+  printTotals("L1 instruction", sim->instruction.hits,
+              sim->instruction.misses, out);
+  printTotals("L1 data", sim->data.hits, sim->data.misses, out);
+  if (config->tlbEntries) {
+    printTotals("Instruction TLB", sim->instructionTlb.hits,
+                sim->instructionTlb.misses, out);
+    printTotals("Data TLB", sim->dataTlb.hits, sim->dataTlb.misses, out);
+  }
+
+  int count = 0;
+  for (int i = 0; i < MEM_SIZE_WORDS; i++) {
+    if (!sim->fetches[i] && !sim->accesses[i]) {
+      continue;
+    }
+    cache_counts_t entry = {i * 4, sim->fetches[i], sim->fetchMisses[i],
+                            sim->accesses[i], sim->accessMisses[i]};
+    entries[count++] = entry;
+    int index = findSymbol(symbols, i * 4) + 1;
+    cache_counts_t *label = &labels[index];
+    label->address = index;
+    label->fetches += entry.fetches;
+    label->fetchMisses += entry.fetchMisses;
+    label->accesses += entry.accesses;
+    label->accessMisses += entry.accessMisses;
+  }
+  qsort(entries, count, sizeof(cache_counts_t), compareMisses);
+
+  fprintf(out, "%-10s %12s %12s %12s %12s  %s\n", "Address", "Fetches",
+          "I misses", "Accesses", "D misses", "Location");
+  for (int i = 0; i < count && i < CACHE_TOP_ENTRIES; i++) {
+    fprintf(out, "0x%.8x %12" PRIu64 " %12" PRIu64 " %12" PRIu64 " %12"
+            PRIu64, entries[i].address, entries[i].fetches,
+            entries[i].fetchMisses, entries[i].accesses,
+            entries[i].accessMisses);
+    printLocation(symbols, entries[i].address, out);
+  }
+
+  if (symbols->symbolCount) {
+    qsort(labels, symbols->symbolCount + 1, sizeof(cache_counts_t),
+          compareMisses);
+    fprintf(out, "%-20s %12s %7s %12s %7s\n", "Label", "I misses", "%",
+            "D misses", "%");
+    for (int i = 0; i <= symbols->symbolCount; i++) {
+      cache_counts_t *label = &labels[i];
+      if (!label->fetches && !label->accesses) {
+        continue;
+      }
+      fprintf(out, "%-20s %12" PRIu64 " %6.2f%% %12" PRIu64 " %6.2f%%\n",
+              label->address ? symbols->symbols[label->address - 1].name
+                             : "(start)",
+              label->fetchMisses, missRate(label->fetchMisses,
+                                           label->fetches),
+              label->accessMisses, missRate(label->accessMisses,
+                                            label->accesses));
+    }
+  }
+
+  free(entries);
+  free(labels);
+}
@@ -0,0 +1,114 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "profile.h"
+
+// ARM1176JZF-S defaults: 16KB 4 way caches of 32 byte lines with pseudo
+// random replacement and 10 entry micro TLBs of 4KB pages
+#define DEFAULT_CACHE_SIZE (16 * 1024)
+#define DEFAULT_CACHE_WAYS 4
+#define DEFAULT_CACHE_LINE 32
+#define DEFAULT_TLB_ENTRIES 10
+#define TLB_PAGE_SIZE 4096
+#define MAX_CACHE_WAYS 64
+#define MAX_TLB_ENTRIES 64
+#define CACHE_TOP_ENTRIES 20
+#define RANDOM_SEED 0x2545F491u
+
+/*-------------TypeDefinitions------------------*/
+typedef struct cache_config cache_config_t;
+
+typedef struct cache cache_t;
+
+typedef struct tlb tlb_t;
+
+typedef struct cache_counts cache_counts_t;
+
+/*-------------Defining the caches--------------*/
+enum replacement {
+  REPLACE_RANDOM,
+  REPLACE_ROUND_ROBIN,
+  REPLACE_LRU,
+  REPLACE_FIFO
+};
+
+typedef enum replacement replacement_t;
+
+struct cache_config {
+  int size; //bytes
+  int ways;
+  int line; //bytes, a power of 2
+  replacement_t policy;
+  int tlbEntries; //0 for no TLB
+};
+
+/*A set associative cache: the tags of the lines of set s are at
+  s * ways, stamps are the times of the last access (LRU) or of the fill
+  (FIFO) and victims the next way of each set to replace (round robin)*/
+struct cache {
+  cache_config_t config;
+  int sets;
+  uint32_t *tags;
+  bool *valid;
+  uint64_t *stamps;
+  int *victims;
+  uint64_t time;
+  uint32_t random;
+  uint64_t hits;
+  uint64_t misses;
+};
+
+/*A fully associative TLB with LRU replacement*/
+struct tlb {
+  int entries;
+  uint32_t pages[MAX_TLB_ENTRIES];
+  uint64_t stamps[MAX_TLB_ENTRIES];
+  int used;
+  uint64_t time;
+  uint64_t hits;
+  uint64_t misses;
+};
+
+struct cache_counts {
+  uint32_t address;
+  uint64_t fetches;
+  uint64_t fetchMisses;
+  uint64_t accesses;
+  uint64_t accessMisses;
+};
+
+struct cache_sim {
+  cache_t instruction;
+  cache_t data;
+  tlb_t instructionTlb;
+  tlb_t dataTlb;
+  //by the word address of the instruction fetched or accessing the data
+  uint64_t fetches[MEM_SIZE_WORDS];
+  uint64_t fetchMisses[MEM_SIZE_WORDS];
+  uint64_t accesses[MEM_SIZE_WORDS];
+  uint64_t accessMisses[MEM_SIZE_WORDS];
+};
+
+/*------------------Prototypes-------------------*/
+bool parseCacheConfig(const char *spec, cache_config_t *config);
+/*sets the fields of config given in spec as "size=16k,ways=4,line=32,
+  policy=random|rr|lru|fifo,tlb=10". Returns false if spec is invalid*/
+
+cache_sim_t *createCacheSim(cache_config_t config);
+/*returns empty instruction and data caches and TLBs of config*/
+
+void destroyCacheSim(cache_sim_t *sim);
+/*frees the caches*/
+
+bool cacheFetch(cache_sim_t *sim, int address);
+/*simulates the fetch of the instruction at address, returns true on a hit*/
+
+bool cacheAccess(cache_sim_t *sim, int address, int pc);
+/*simulates the load or store of the word at address by the instruction at
+  pc, returns true if every line of the word hit*/
+
+void printCacheSim(cache_sim_t *sim, profile_t *symbols, FILE *out);
+/*prints the hits and misses of the caches and TLBs, the instructions with
+  the most misses and the misses of every label*/
+
+#endif
@@ -1,12 +1,32 @@
 #include "instructionManipulation.h"
 #include "emulate.h"
+#include "profile.h"
+#include "sample.h"
+#include "trace.h"
+#include "stats.h"
+#include "live.h"
+#include "heatmap.h"
+#include "cache.h"
+#include "timing.h"
+#include "predictor.h"
 
 int main(int argc, char **argv) {
-  if(!argv[1]) {
+  options_t options = {NULL, NULL, NULL, DEFAULT_SAMPLE_RATE, NULL, NULL,
+                       NULL, NULL, NULL, 0, 0, NULL};
+  int arg = 1;
+  //options come before the binary file
+  while(arg < argc && argv[arg][0] == '-') {
+    if(!parseOption(argv[arg], &options)) {
+      fprintf(stderr, "Unknown option %s\n", argv[arg]);
+      return EXIT_FAILURE;
+    }
+    arg++;
+  }
+  if(arg >= argc) {
    fprintf(stderr, "%s\n", "Wrong number of arguments");
    return EXIT_FAILURE;
   }
-  FILE *file = fopen(argv[1], "rb");
+  FILE *file = fopen(argv[arg], "rb");
   proc_state_t *pStatePtr = (proc_state_t *) malloc(sizeof(proc_state_t));
   //Initialisation of pState
   pStatePtr->NEG = 0;
@@ -14,6 +34,40 @@ int main(int argc, char **argv) {
   pStatePtr->CRY = 0;
   pStatePtr->OVF = 0;
   pStatePtr->PC = 0;
+  pStatePtr->executing = 0;
+  pStatePtr->profile = NULL;
+  pStatePtr->trace = NULL;
+  pStatePtr->stats = options.stats ? createStats() : NULL;
+  pStatePtr->live = NULL;
+  pStatePtr->heatmap = options.heatmap ? createHeatmap() : NULL;
+  pStatePtr->cache = NULL;
+  pStatePtr->timing = NULL;
+  if(options.maxCycles && !options.clockMhz) {
+    fprintf(stderr, "%s\n", "--max-cycles needs --timing");
+    exit(EXIT_FAILURE);
+  }
+  if(options.clockMhz) {
+    pStatePtr->timing = createTiming(options.clockMhz, options.maxCycles);
+  }
+  pStatePtr->predictor = NULL;
+  if(options.predictor) {
+    predictor_kind_t kind = PREDICT_BTAC;
+    if(*options.predictor && !parsePredictor(options.predictor, &kind)) {
+      fprintf(stderr, "Unknown branch predictor %s\n", options.predictor);
+      exit(EXIT_FAILURE);
+    }
+    pStatePtr->predictor = createPredictor(kind);
+  }
+  if(options.cache) {
+    cache_config_t config = {DEFAULT_CACHE_SIZE, DEFAULT_CACHE_WAYS,
+                             DEFAULT_CACHE_LINE, REPLACE_RANDOM,
+                             DEFAULT_TLB_ENTRIES};
+    if(!parseCacheConfig(options.cache, &config)) {
+      fprintf(stderr, "Invalid cache configuration %s\n", options.cache);
+      exit(EXIT_FAILURE);
+    }
+    pStatePtr->cache = createCacheSim(config);
+  }
   for(int i = 0; i < MEM_SIZE_WORDS; i++) {
     pStatePtr->memory[i] = 0;
   }
@@ -25,12 +79,232 @@ int main(int argc, char **argv) {
     perror("calloc");
     exit(EXIT_FAILURE);
   }
-  memoryLoader(file, pStatePtr);
+  if(options.profile) {
+    pStatePtr->profile = createProfile();
+    loadProfileSymbols(pStatePtr->profile, options.symbols, argv[arg]);
+  }
+  if(options.trace && !(pStatePtr->trace = openTrace(options.trace))) {
+    perror(options.trace);
+    exit(EXIT_FAILURE);
+  }
+  if(options.live && !(pStatePtr->live = openLive(options.live))) {
+    perror("shm_open");
+    exit(EXIT_FAILURE);
+  }
+  int imageWords = memoryLoader(file, pStatePtr);
+  if(options.sample) {
+    startSampler(pStatePtr, options.sampleRate);
+  }
+  if(pStatePtr->stats) {
+    startStats(pStatePtr->stats);
+  }
   procCycle(pStatePtr);
+  if(pStatePtr->stats) {
+    stopStats(pStatePtr->stats);
+  }
+  if(options.sample) {
+    stopSampler();
+  }
+  if(pStatePtr->live) {
+    closeLive(pStatePtr->live, pStatePtr);
+  }
+  if(pStatePtr->trace && !closeTrace(pStatePtr->trace)) {
+    fprintf(stderr, "The trace %s could not be written\n", options.trace);
+  }
+  if(pStatePtr->profile) {
+    //the hotspot report goes after the processor state
+    FILE *report = *options.profile ? fopen(options.profile, "w") : stdout;
+    if(!report) {
+      perror(options.profile);
+    } else {
+      printProfile(pStatePtr->profile, report);
+      if(report != stdout) {
+        fclose(report);
+      }
+    }
+    destroyProfile(pStatePtr->profile);
+  }
+  if(options.sample) {
+    printSampleReport(&options, argv[arg]);
+  }
+  if(pStatePtr->timing) {
+    printTiming(pStatePtr->timing, stdout);
+    free(pStatePtr->timing);
+  }
+  if(pStatePtr->predictor) {
+    printPredictorReport(&options, pStatePtr->predictor, argv[arg]);
+    free(pStatePtr->predictor);
+  }
+  if(pStatePtr->cache) {
+    printCacheReport(&options, pStatePtr->cache, argv[arg]);
+    destroyCacheSim(pStatePtr->cache);
+  }
+  if(pStatePtr->heatmap) {
+    printHeatmapReport(&options, pStatePtr->heatmap, argv[arg],
+                       imageWords);
+    free(pStatePtr->heatmap);
+  }
+  if(pStatePtr->stats) {
+    writeStatsReport(&options, pStatePtr->stats, argv[arg]);
+    free(pStatePtr->stats);
+  }
   free(pStatePtr);
   return EXIT_SUCCESS;
 }
 
+bool parsePositive(char *text, long maximum, long *value) {
+  char *end;
+  *value = strtol(text, &end, 10);
+  return !*end && end != text && *value >= 1 && *value <= maximum;
+}
+
+bool parseOption(char *option, options_t *options) {
+  long value;
+  if(!strcmp(option, "--profile")) {
+    options->profile = "";
+  } else if(!strncmp(option, "--profile=", 10) && option[10]) {
+    options->profile = option + 10;
+  } else if(!strncmp(option, "--symbols=", 10) && option[10]) {
+    options->symbols = option + 10;
+  } else if(!strncmp(option, "--trace=", 8) && option[8]) {
+    options->trace = option + 8;
+  } else if(!strcmp(option, "--live")) {
+    options->live = "";
+  } else if(!strncmp(option, "--live=", 7) && option[7]) {
+    options->live = option + 7;
+  } else if(!strcmp(option, "--heatmap")) {
+    options->heatmap = "";
+  } else if(!strncmp(option, "--heatmap=", 10) && option[10]) {
+    options->heatmap = option + 10;
+  } else if(!strcmp(option, "--cache")) {
+    options->cache = "";
+  } else if(!strncmp(option, "--cache=", 8) && option[8]) {
+    options->cache = option + 8;
+  } else if(!strcmp(option, "--timing")) {
+    options->clockMhz = DEFAULT_CLOCK_MHZ;
+  } else if(!strncmp(option, "--timing=", 9)) {
+    if(!parsePositive(option + 9, MAX_CLOCK_MHZ, &value)) {
+      return false;
+    }
+    options->clockMhz = value;
+  } else if(!strncmp(option, "--max-cycles=", 13)) {
+    if(!parsePositive(option + 13, LONG_MAX, &value)) {
+      return false;
+    }
+    options->maxCycles = value;
+  } else if(!strcmp(option, "--predictor")) {
+    options->predictor = "";
+  } else if(!strncmp(option, "--predictor=", 12) && option[12]) {
+    options->predictor = option + 12;
+  } else if(!strcmp(option, "--stats=json")) {
+    options->stats = "";
+  } else if(!strncmp(option, "--stats=json=", 13) && option[13]) {
+    options->stats = option + 13;
+  } else if(!strcmp(option, "--sample")) {
+    options->sample = "";
+  } else if(!strncmp(option, "--sample=", 9) && option[9]) {
+    options->sample = option + 9;
+  } else if(!strncmp(option, "--sample-rate=", 14)) {
+    if(!parsePositive(option + 14, MAX_SAMPLE_RATE, &value)) {
+      return false;
+    }
+    options->sampleRate = value;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void loadProfileSymbols(profile_t *profile, char *symbols, char *image) {
+  if(symbols) {
+    if(!loadSymbols(profile, symbols)) {
+      fprintf(stderr, "The symbol file %s was not found\n", symbols);
+    }
+    return;
+  }
+  //the symbols written by assemble --symbols next to the image, if any
+  char *path = sidecarPath(image, SYMBOL_SUFFIX);
+  loadSymbols(profile, path);
+  free(path);
+}
+
+char *sidecarPath(char *image, char *suffix) {
+  char *path = malloc(strlen(image) + strlen(suffix) + 1);
+  if(!path) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+  strcpy(path, image);
+  strcat(path, suffix);
+  return path;
+}
+
+void printSampleReport(options_t *options, char *image) {
+  //only the symbols of the profile are used, its counters hold the samples
+  profile_t *profile = createProfile();
+  loadProfileSymbols(profile, options->symbols, image);
+  printSamples(profile, stdout);
+
+  char *path = *options->sample ? options->sample
+                                 : sidecarPath(image, FOLDED_SUFFIX);
+  if(!writeFoldedStacks(profile, path)) {
+    perror(path);
+  }
+  if(path != options->sample) {
+    free(path);
+  }
+  destroyProfile(profile);
+  freeSamples();
+}
+
+void printCacheReport(options_t *options, cache_sim_t *cache, char *image) {
+  profile_t *symbols = createProfile();
+  loadProfileSymbols(symbols, options->symbols, image);
+  printCacheSim(cache, symbols, stdout);
+  destroyProfile(symbols);
+}
+
+void printPredictorReport(options_t *options, predictor_t *predictor,
+                          char *image) {
+  profile_t *symbols = createProfile();
+  loadProfileSymbols(symbols, options->symbols, image);
+  printPredictor(predictor, symbols, stdout);
+  destroyProfile(symbols);
+}
+
+void printHeatmapReport(options_t *options, heatmap_t *heatmap, char *image,
+                        int imageWords) {
+  profile_t *symbols = createProfile();
+  loadProfileSymbols(symbols, options->symbols, image);
+  printHeatmap(heatmap, symbols, imageWords * 4, stdout);
+  destroyProfile(symbols);
+
+  char *path = *options->heatmap ? options->heatmap
+                                 : sidecarPath(image, HEATMAP_SUFFIX);
+  if(!writeHeatmap(heatmap, path)) {
+    perror(path);
+  }
+  if(path != options->heatmap) {
+    free(path);
+  }
+}
+
+void writeStatsReport(options_t *options, stats_t *stats, char *image) {
+  //not on the standard output, which holds the processor state
+  char *path = *options->stats ? options->stats
+                               : sidecarPath(image, STATS_SUFFIX);
+  FILE *report = fopen(path, "w");
+  if(!report) {
+    perror(path);
+  } else {
+    printStats(stats, report);
+    fclose(report);
+  }
+  if(path != options->stats) {
+    free(path);
+  }
+}
+
 void procCycle(proc_state_t *pState) {
   pipeline_t pipeline = {-1, -1};
   bool finished = false;
@@ -39,15 +313,23 @@ void procCycle(proc_state_t *pState) {
   pState->regs[INDEX_PC] = pState->PC;
   // PC is stored twice in pState(regs array and separate field)
   pipeline.fetched = pState->memory[0];
+  if (pState->cache) {
+    cacheFetch(pState->cache, 0);
+  }
   while (!finished) {
     pState->PC += 4;
     pState->regs[INDEX_PC] = pState->PC;
     pipeline.decoded = pipeline.fetched;
     pipeline.fetched = pState->memory[pState->PC / 4 - 1];
+    if (pState->cache) {
+      cacheFetch(pState->cache, pState->PC - 4);
+    }
     if (pipeline.decoded != -1) {
       decodeFetched(pipeline.decoded, pState, &pipeline);
+      PROBE2(emulate, retire, pState->executing, pipeline.decoded);
     }
-    finished = !pipeline.decoded;
+    finished = !pipeline.decoded ||
+               (pState->timing && timingExpired(pState->timing));
   }
   printProcessorState(pState);
 }
@@ -266,12 +548,16 @@ void executeOperation(proc_state_t *pState, int Rdest,
 
 //--------------Execute SDataTransferI------------------------------------------
 void executeSDataTransfer(int instruction, proc_state_t *pState) {
+  if(pState->profile) {
+    profileMemoryAccess(pState->profile);
+  }
   int I = getISingle(instruction);
   int L = getLBit(instruction);
   int P = getPBit(instruction);
   int U = getUBit(instruction);
   int Rn = getRn(instruction);
   int Rd = getRdSingle(instruction);
+  int stored = pState->regs[Rd];
   int offset = -1;
   if(I) {
     //Offset interpreted as a shifted register
@@ -331,22 +617,34 @@ void executeSDataTransfer(int instruction, proc_state_t *pState) {
        pState->regs[Rn] = getEffectiveAddress(Rn, offset, U, pState);
      }
   }
+  if(pState->trace) {
+    traceMemoryAccess(pState->trace, address, !L, stored);
+  }
+  if(pState->stats) {
+    countTransfer(pState->stats, address, !L);
+  }
+  if(pState->live) {
+    liveTransfer(pState->live, address, !L, stored);
+  }
 }
 
 
 void executeLoadFromMemoryGPIO(proc_state_t *pState, int Rd, int address) {
   switch (address) {
     case GPIOo_9_ADDRESS:
+                  PROBE1(emulate, mmio__load, address);
                   printf("%s\n",
                   "One GPIO pin from 0 to 9 has been accessed");
                   pState->regs[Rd] = GPIOo_9_ADDRESS;
                   break;
     case GPIO10_19_ADDRESS:
+                  PROBE1(emulate, mmio__load, address);
                     printf("%s\n",
                     "One GPIO pin from 10 to 19 has been accessed");
                     pState->regs[Rd] = GPIO10_19_ADDRESS;
                     break;
     case GPIO20_29_ADDRESS:
+                  PROBE1(emulate, mmio__load, address);
                     printf("%s\n",
                     "One GPIO pin from 20 to 29 has been accessed");
                     pState->regs[Rd] = GPIO20_29_ADDRESS;
@@ -404,28 +702,36 @@ void writeToMemory(int word, int startByteAddress, proc_state_t *pState) {
   //changedPin is the index of the pin that has been set as output
   switch(startByteAddress) {
    case GPIOo_9_ADDRESS:
+                        PROBE2(emulate, mmio__store, startByteAddress, word);
                         printf("%s\n",
                         "One GPIO pin from 0 to 9 has been accessed");
                         gpioPhysical[0] = word;
   //                      changedPin = getChangedOutputPin(word, 0);
                         break;
    case GPIO10_19_ADDRESS:
+                        PROBE2(emulate, mmio__store, startByteAddress, word);
                         printf("%s\n",
                         "One GPIO pin from 10 to 19 has been accessed");
                         gpioPhysical[1] = word;
     //                    changedPin = getChangedOutputPin(word, 1);
                         break;
    case GPIO20_29_ADDRESS:
+                        PROBE2(emulate, mmio__store, startByteAddress, word);
                         printf("%s\n",
                         "One GPIO pin from 20 to 29 has been accessed");
                         gpioPhysical[2] = word;
       //                  changedPin = getChangedOutputPin(word, 2);
                         break;
-   case GPIO_OUTPUT_ON: printf("%s\n", "PIN ON");
+   case GPIO_OUTPUT_ON: PROBE2(emulate, mmio__store, startByteAddress, word);
+                        if(pState->timing) {
+                          timePinOn(pState->timing);
+                        }
+                        printf("%s\n", "PIN ON");
                         gpioOutputOnOff[0] = word;
                         break;
 
-   case GPIO_OUTPUT_OFF: printf("%s\n", "PIN OFF");
+   case GPIO_OUTPUT_OFF: PROBE2(emulate, mmio__store, startByteAddress, word);
+                         printf("%s\n", "PIN OFF");
                          gpioOutputOnOff[1] = word;
                          break;
 
@@ -439,6 +745,12 @@ void writeToMemory(int word, int startByteAddress, proc_state_t *pState) {
 void fillByteAddress(int startByteAddress, proc_state_t *pState, int *byteArr) {
   //Starting from mem[startByteAddress], function replaces existing bytes
   //with bytes from the array referenced by byteArr
+  if(pState->heatmap) {
+    heatmapAccess(pState->heatmap, startByteAddress, true);
+  }
+  if(pState->cache) {
+    cacheAccess(pState->cache, startByteAddress, pState->executing);
+  }
   for(int i = 0; i < 4; i++) {
     pState->memory[startByteAddress / 4] =
     setByte(pState->memory[startByteAddress / 4],
@@ -450,6 +762,12 @@ void fillByteAddress(int startByteAddress, proc_state_t *pState, int *byteArr) {
 
 
 int getMemoryContentsAtAddress(proc_state_t *pState, int address) {
+  if(pState->heatmap) {
+    heatmapAccess(pState->heatmap, address, false);
+  }
+  if(pState->cache) {
+    cacheAccess(pState->cache, address, pState->executing);
+  }
   int byteAddress = address;
   int byte0 = getByteBigEndian(pState->memory[byteAddress / 4],
                                3 - (byteAddress % 4));
@@ -512,6 +830,10 @@ void executeBranch(int instruction, proc_state_t *pState, pipeline_t *pipeline){
     int PCvalue = pState-> PC;
     pState->PC = PCvalue + offset;
     pState->regs[INDEX_PC] = pState->PC;
+    PROBE2(emulate, branch, pState->executing, pState->PC);
+    if(pState->timing && !pState->predictor) {
+      timeBranchFlush(pState->timing);
+    }
     pipeline->decoded = -1;
     pipeline->fetched = -1;
 }
@@ -521,25 +843,35 @@ void executeBranch(int instruction, proc_state_t *pState, pipeline_t *pipeline){
 
 void decodeFetched(int instruction, proc_state_t *pState, pipeline_t *pipeline){
    int idBits = extractIDbits(instruction);
+   //check if Cond satisfied before executing
+   bool execute = shouldExecute(instruction, pState);
+   //the instruction was fetched 8 bytes before the PC
+   pState->executing = pState->PC - 8;
+   if(pState->profile) {
+     profileInstruction(pState->profile, pState->executing, execute);
+   }
    if(idBits == 1) {
-     //check if Cond satisfied before executing
-       if(shouldExecute(instruction, pState)) {
+       if(execute) {
         executeSDataTransfer(instruction, pState);
        }
    } else if(idBits == 2) {
-     //check if Cond satisfied before executing
-      if(shouldExecute(instruction, pState)) {
+      if(pState->predictor &&
+         predictBranch(pState->predictor, pState->executing, instruction,
+                       execute) && pState->timing) {
+        //only a mispredicted branch refills the pipeline
+        timeBranchFlush(pState->timing);
+      }
+      if(execute) {
         executeBranch(instruction, pState, pipeline);
       }
    } else if(!idBits) {
       //Choose between MultiplyI and DataProcessingI
        if(isMult(instruction)) {
-         if(shouldExecute(instruction, pState)) {
+         if(execute) {
            executeMultiply(instruction, pState);
          }
        } else {
-         //Then check if Cond satisfied before executing
-         if(shouldExecute(instruction, pState)) {
+         if(execute) {
           executeDataProcessing(instruction, pState);
          }
        }
@@ -548,6 +880,19 @@ void decodeFetched(int instruction, proc_state_t *pState, pipeline_t *pipeline){
      fprintf(stderr, "%s\n", "Invalid instruction executing.");
      exit(EXIT_FAILURE);
    }
+   if(pState->trace) {
+     traceInstruction(pState->trace, pState, execute);
+   }
+   if(pState->stats && instruction) {
+     //the andeq r0, r0, r0 which halts the run is not counted
+     countInstruction(pState->stats, instruction, execute);
+   }
+   if(pState->live) {
+     liveInstruction(pState->live, pState, execute);
+   }
+   if(pState->timing) {
+     timeInstruction(pState->timing, instruction, execute);
+   }
 
   /*when executing: if Cond succeeds or is al(always), instruction
     is executed. Otherwise not */
@@ -572,16 +917,17 @@ bool shouldExecute(int instruction, proc_state_t *pState) {
 
 
 
-void memoryLoader(FILE *file, proc_state_t *pState) {
+int memoryLoader(FILE *file, proc_state_t *pState) {
   //Pointers are passed to functions by value(they are addresses)
   //So, passing *file makes a copy of the original pointer
   if(!file) {
     fprintf(stderr, "%s\n", "File not found");
   }
-  fread(pState->memory, sizeof(uint32_t), MEM_SIZE_WORDS, file);
+  int words = fread(pState->memory, sizeof(uint32_t), MEM_SIZE_WORDS, file);
   fclose(file);
   //load every instruction in binary file into memory
   //Instructions stored in Big Endian, ready to be decoded
+  return words;
 }
 
 void printMemory(int memory[]) {
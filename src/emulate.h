@@ -1,4 +1,8 @@
+#ifndef EMULATE_H
+#define EMULATE_H
+
 #include "headers.h"
+#include "probes.h"
 #include <limits.h>
 #include <stdbool.h>
 #include <assert.h>
@@ -14,12 +18,31 @@
 #define GPIOo_9_ADDRESS 0x20200000
 #define GPIO_OUTPUT_OFF 0x20200028
 #define GPIO_OUTPUT_ON 0x2020001C
+#define MAX_CLOCK_MHZ 10000
 
 /*-------------TypeDefinitions------------------*/
 typedef struct proc_state proc_state_t;
 
 typedef struct pipeline pipeline_t;
 
+typedef struct profile profile_t;
+
+typedef struct options options_t;
+
+typedef struct trace trace_t;
+
+typedef struct stats stats_t;
+
+typedef struct live live_t;
+
+typedef struct heatmap heatmap_t;
+
+typedef struct cache_sim cache_sim_t;
+
+typedef struct timing timing_t;
+
+typedef struct predictor predictor_t;
+
 /*-------------Defining processor state---------*/
 struct proc_state {
   int NEG;
@@ -27,8 +50,17 @@ struct proc_state {
   int CRY;
   int OVF;
   int PC;
+  int executing; //address of the instruction in decodeFetched
   int regs[NUMBER_REGS];
   int memory[MEM_SIZE_WORDS];
+  profile_t *profile; //NULL unless --profile
+  trace_t *trace; //NULL unless --trace
+  stats_t *stats; //NULL unless --stats
+  live_t *live; //NULL unless --live
+  heatmap_t *heatmap; //NULL unless --heatmap
+  cache_sim_t *cache; //NULL unless --cache
+  timing_t *timing; //NULL unless --timing
+  predictor_t *predictor; //NULL unless --predictor
 };
 
 struct pipeline {
@@ -36,7 +68,52 @@ struct pipeline {
   int decoded;
 };
 
+/*-------------Command line options-------------*/
+struct options {
+  char *profile; //--profile[=FILE], "" for the standard output
+  char *symbols; //--symbols=FILE, by default the image followed by .sym
+  char *sample; //--sample[=FILE] folded stacks, "" for the image + .folded
+  int sampleRate; //--sample-rate=HZ
+  char *trace; //--trace=FILE
+  char *stats; //--stats=json[=FILE], "" for the image followed by .stats.json
+  char *live; //--live[=NAME] shared memory, "" for /emulate.<pid>
+  char *heatmap; //--heatmap[=FILE], "" for the image followed by .heat
+  char *cache; //--cache[=SPEC], see parseCacheConfig
+  int clockMhz; //--timing[=MHZ], 0 without the timing model
+  uint64_t maxCycles; //--max-cycles=N, stops the timed run
+  char *predictor; //--predictor[=static|bimodal|btac]
+};
+
 /*------------------Prototypes-------------------*/
+bool parsePositive(char *text, long maximum, long *value);
+/*reads a number from 1 to maximum into value, returns false otherwise*/
+
+bool parseOption(char *option, options_t *options);
+/*sets the option in options, returns false if the option is unknown*/
+
+void loadProfileSymbols(profile_t *profile, char *symbols, char *image);
+/*loads the symbol file given by --symbols, or the one next to the image*/
+
+char *sidecarPath(char *image, char *suffix);
+/*returns the path of image followed by suffix, to be freed*/
+
+void printSampleReport(options_t *options, char *image);
+/*prints the histogram of the samples and writes their folded stacks*/
+
+void printCacheReport(options_t *options, cache_sim_t *cache, char *image);
+/*prints the hits and misses of the caches with the labels of the image*/
+
+void printPredictorReport(options_t *options, predictor_t *predictor,
+                          char *image);
+/*prints the mispredictions with the labels of the image*/
+
+void printHeatmapReport(options_t *options, heatmap_t *heatmap, char *image,
+                        int imageWords);
+/*prints the summary of the heatmap and writes it to its file*/
+
+void writeStatsReport(options_t *options, stats_t *stats, char *image);
+/*writes the statistics of the run to their file as a JSON object*/
+
 bool shouldExecute(int instruction, proc_state_t *pState);
 /*returns true iff the instruction should be executed*/
 
@@ -58,9 +135,9 @@ void executeMultiply(int instruction, proc_state_t *pState);
 void executeBranch(int instruction, proc_state_t *pState, pipeline_t *pipeline);
 /*Changes the value of PC and ignores previously fetched instruction*/
 
-void memoryLoader(FILE *file, proc_state_t *pState);
+int memoryLoader(FILE *file, proc_state_t *pState);
 /*writes MEM_SIZE_WORDS starting at address on the stack indicated by memory
- field of proc_state_t */
+ field of proc_state_t, returns the number of words of the image */
 
 void printProcessorState(proc_state_t *pState);
 /*Prints register contents and memory*/
@@ -102,3 +179,5 @@ void printMemory(int memory[]);
 
 int convertToLittleEndian(int instruction);
 /*returns little endian representation of an instruction/value*/
+
+#endif
@@ -0,0 +1,63 @@
+#include "live.h"
+
+#define HEADER_EVERY 20
+
+static void printHeader(void) {
+  printf("%14s %10s %9s", "retired", "pc", "mips");
+  for(int i = 0; i < DEVICES; i++) {
+    printf(" %10s", DEVICE_NAMES[i]);
+  }
+  printf(" %10s\n", "pins");
+}
+
+int main(int argc, char **argv) {
+  if(argc < 2 || argc > 3) {
+    fprintf(stderr, "%s\n", "Usage: emustat name [seconds]");
+    return EXIT_FAILURE;
+  }
+  char name[MAX_LIVE_NAME_LENGTH];
+  snprintf(name, MAX_LIVE_NAME_LENGTH, "%s%s", *argv[1] == '/' ? "" : "/",
+           argv[1]);
+  double interval = argc == 3 ? atof(argv[2]) : 1.0;
+  if(interval <= 0) {
+    fprintf(stderr, "%s\n", "The interval must be positive");
+    return EXIT_FAILURE;
+  }
+
+  int fd = shm_open(name, O_RDONLY, 0);
+  if(fd < 0) {
+    perror(name);
+    return EXIT_FAILURE;
+  }
+  void *mapping = mmap(NULL, sizeof(live_block_t), PROT_READ, MAP_SHARED, fd,
+                       0);
+  close(fd);
+  if(mapping == MAP_FAILED) {
+    perror("mmap");
+    return EXIT_FAILURE;
+  }
+  volatile const live_block_t *block = mapping;
+
+  struct timespec wait = {(time_t) interval,
+                          (long) ((interval - (time_t) interval) * 1e9)};
+  live_block_t copy;
+  //like vmstat, a line per interval until the emulator finishes
+  for(int line = 0; readLive(block, &copy); line++) {
+    if(!(line % HEADER_EVERY)) {
+      printHeader();
+    }
+    printf("%14" PRIu64 " 0x%.8x %9.3f", copy.retired, copy.pc, copy.mips);
+    for(int i = 0; i < DEVICES; i++) {
+      printf(" %10" PRIu64, copy.loads[i] + copy.stores[i]);
+    }
+    printf(" 0x%.8x\n", copy.pins);
+    fflush(stdout);
+    if(copy.finished) {
+      break;
+    }
+    nanosleep(&wait, NULL);
+  }
+
+  munmap(mapping, sizeof(live_block_t));
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include "fixup.h"
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+// ---------------------------OFFSETS-----------------------------
+uint32_t branchOffset(uint32_t instruction, uint32_t target) {
+  uint32_t offset = target - instruction - PC_OFFSET;
+  offset <<= INSTRUCTION_SIZE - (BRANCH_OFFSET_SIZE - 2);
+  offset >>= INSTRUCTION_SIZE - (BRANCH_OFFSET_SIZE - 2);
+  return offset;
+}
+
+int32_t literalOffset(uint32_t instruction, uint32_t target) {
+  return ((int32_t) target - (int32_t) instruction - PC_OFFSET) * MEMORY_SIZE;
+}
+
+bool literalInRange(int32_t offset) {
+  return offset <= TRANSFER_OFFSET_MASK && -offset <= TRANSFER_OFFSET_MASK;
+}
+
+uint32_t literalField(int32_t offset) {
+  return offset >= 0 ? UP_BIT | offset : (uint32_t) -offset;
+}
+
+// ---------------------------FIXUPS------------------------------
+fixupList constructFixupList(arena *pool) {
+  fixupList f = {NULL, 0, 0, 0, 0, 0, constructMapInArena(pool)};
+  return f;
+}
+
+void clearFixupList(fixupList *f) {
+  free(f->fixups);
+  f->fixups = NULL;
+  f->size = 0;
+  f->capacity = 0;
+  f->unresolved = 0;
+  f->oldest = 0;
+  clearMap(&f->pending);
+}
+
+static fixup *addFixup(fixupList *f) {
+  if (f->size == f->capacity) {
+    f->capacity = f->capacity ? 2 * f->capacity : 64;
+    fixup *fixups = realloc(f->fixups, f->capacity * sizeof(fixup));
+    if (!fixups) {
+      perror("realloc");
+      exit(EXIT_FAILURE);
+    }
+    f->fixups = fixups;
+  }
+
+  return &f->fixups[f->size++];
+}
+
+void addBranchFixup(fixupList *f, const char *label, int length,
+                    uint32_t instruction) {
+  uint32_t *head = getSlice(f->pending, label, length);
+  fixup *new = addFixup(f);
+
+  new->kind        = BRANCH_FIXUP;
+  new->instruction = instruction;
+  new->target      = 0;
+  new->line        = f->line;
+  new->next        = head ? (int) *head : NO_FIXUP;
+  new->resolved    = false;
+
+  if (head) {
+    *head = f->size - 1;
+  } else {
+    char *key = arenaCopy(f->pending.pool, label, length);
+    put(&f->pending, key, f->size - 1);
+  }
+  f->unresolved++;
+}
+
+void addLiteralFixup(fixupList *f, uint32_t instruction, uint32_t slot) {
+  fixup *new = addFixup(f);
+
+  new->kind        = LITERAL_FIXUP;
+  new->instruction = instruction;
+  new->target      = slot;
+  new->line        = f->line;
+  new->next        = NO_FIXUP;
+  new->resolved    = false;
+}
+
+uint32_t oldestPendingFixup(fixupList *f) {
+  while (f->oldest < f->size && f->fixups[f->oldest].resolved) {
+    f->oldest++;
+  }
+
+  return f->oldest < f->size ? f->fixups[f->oldest].instruction
+                             : NO_PENDING_FIXUP;
+}
+
+void resolveLabel(fixupList *f, const char *label, uint32_t address,
+                  outputWriter *output) {
+  uint32_t *head = get(f->pending, (char *) label);
+
+  if (!head) {
+    return;
+  }
+
+  for (int i = *head; i != NO_FIXUP; i = f->fixups[i].next) {
+    uint32_t instruction = f->fixups[i].instruction;
+    patchWord(output, instruction, BRANCH_OFFSET_MASK,
+              branchOffset(instruction, address));
+    f->fixups[i].resolved = true;
+    f->unresolved--;
+  }
+  *head = NO_FIXUP;
+}
+
+bool resolveLiterals(fixupList *f, uint32_t poolStart, outputWriter *output) {
+  bool inRange = true;
+
+  for (int i = f->oldest; i < f->size; i++) {
+    if (f->fixups[i].kind == LITERAL_FIXUP && !f->fixups[i].resolved) {
+      uint32_t instruction = f->fixups[i].instruction;
+      // from now on target is the address of the literal
+      f->fixups[i].target += poolStart;
+      int32_t offset = literalOffset(instruction, f->fixups[i].target);
+      inRange &= literalInRange(offset);
+      patchWord(output, instruction, LITERAL_FIELD_MASK,
+                literalField(offset));
+      f->fixups[i].resolved = true;
+    }
+  }
+
+  return inRange;
+}
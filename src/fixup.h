@@ -0,0 +1,112 @@
+#ifndef FIXUP_H
+#define FIXUP_H
+
+#include "adts.h"
+#include "output.h"
+
+// ---------------------------MACROS-----------------------------
+#define MEMORY_SIZE 4
+#define PC_OFFSET 2
+#define INSTRUCTION_SIZE 32
+#define BRANCH_OFFSET_SIZE  26
+#define BRANCH_OFFSET_MASK 0xFFFFFF
+#define TRANSFER_OFFSET_MASK 0xFFF
+#define UP_BIT (1 << 23)
+#define LITERAL_FIELD_MASK (UP_BIT | TRANSFER_OFFSET_MASK)
+#define NO_FIXUP -1
+#define NO_PENDING_FIXUP UINT32_MAX
+
+// -------------------------TYPES---------------------------------
+typedef struct fixup fixup;
+typedef struct fixupList fixupList;
+
+// --------------------------ENUMS-------------------------------
+typedef enum {BRANCH_FIXUP, LITERAL_FIXUP} fixupEnum;
+
+// -------------------------STRUCTS-------------------------------
+/**
+* An instruction whose offset field can't be encoded yet:
+* BRANCH_FIXUP   a branch to a label which isn't defined yet, next chains
+*                all the fixups waiting for the same label
+* LITERAL_FIXUP  a ldr from the literal pool, target is the slot in the pool
+*                whose address is known only once the pool is placed, and
+*                the address of the literal after that
+**/
+struct fixup {
+  fixupEnum kind;
+  uint32_t  instruction;
+  uint32_t  target;
+  uint32_t  line;
+  int       next;
+  bool      resolved;
+};
+
+/**
+* pending maps every undefined label which is used to the index of its most
+* recent fixup (NO_FIXUP once it has been resolved)
+* line is the source line being assembled, it is recorded in new fixups so
+* that unresolved labels can be reported
+* oldest is the first fixup which might not be resolved yet
+**/
+struct fixupList {
+  fixup    *fixups;
+  int      size;
+  int      capacity;
+  int      unresolved;
+  int      oldest;
+  uint32_t line;
+  map      pending;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+// ---------------------------OFFSETS-----------------------------
+/* Returns the offset field of a branch from instruction to target */
+uint32_t branchOffset(uint32_t instruction, uint32_t target);
+
+/**
+* Returns the byte offset of a ldr from instruction to the word target, which
+* is negative for a load right before its pool
+**/
+int32_t literalOffset(uint32_t instruction, uint32_t target);
+
+/* Returns true iff the offset fits in the offset field of a ldr */
+bool literalInRange(int32_t offset);
+
+/* Returns the U bit and offset field (LITERAL_FIELD_MASK) for the offset */
+uint32_t literalField(int32_t offset);
+
+// ---------------------------FIXUPS------------------------------
+/* Constructor function that will return an empty list using pool */
+fixupList constructFixupList(arena *pool);
+
+/* Frees the list (the pending labels are owned by the pool) */
+void clearFixupList(fixupList *f);
+
+/* Records that instruction branches to the label which isn't defined yet */
+void addBranchFixup(fixupList *f, const char *label, int length,
+                    uint32_t instruction);
+
+/* Records that instruction loads the literal pool slot */
+void addLiteralFixup(fixupList *f, uint32_t instruction, uint32_t slot);
+
+/**
+* Returns the index of the first instruction which still waits for a fixup
+* or NO_PENDING_FIXUP. Every instruction before it is final
+**/
+uint32_t oldestPendingFixup(fixupList *f);
+
+/**
+* Backpatches every branch waiting for label now that it is known to be at
+* address
+**/
+void resolveLabel(fixupList *f, const char *label, uint32_t address,
+                  outputWriter *output);
+
+/**
+* Backpatches every literal load still waiting for its pool now that the
+* pool starts at poolStart
+* Returns false if a literal is out of range of its load
+**/
+bool resolveLiterals(fixupList *f, uint32_t poolStart, outputWriter *output);
+
+#endif
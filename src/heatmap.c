@@ -0,0 +1,115 @@
+#include "heatmap.h"
+
+heatmap_t *createHeatmap(void) {
+  heatmap_t *heatmap = calloc(1, sizeof(heatmap_t));
+  if (!heatmap) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  return heatmap;
+}
+
+//--------------Binary---------------------------------------------------------
+static bool putLittleEndian(uint64_t value, int bytes, FILE *file) {
+  for (int i = 0; i < bytes; i++) {
+    if (putc((value >> (8 * i)) & 0xFF, file) == EOF) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool writeHeatmap(heatmap_t *heatmap, const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    return false;
+  }
+  bool written = fwrite(HEATMAP_MAGIC, 1, HEATMAP_MAGIC_LENGTH, file) ==
+                 HEATMAP_MAGIC_LENGTH &&
+                 putLittleEndian(HEATMAP_VERSION, 4, file) &&
+                 putLittleEndian(HEATMAP_LINE_SIZE, 4, file) &&
+                 putLittleEndian(HEATMAP_LINES, 4, file);
+  for (int i = 0; i < HEATMAP_LINES && written; i++) {
+    written = putLittleEndian(heatmap->reads[i], 8, file) &&
+              putLittleEndian(heatmap->writes[i], 8, file);
+  }
+  return !fclose(file) && written;
+}
+
+//--------------Summary--------------------------------------------------------
+static int compareAccesses(const void *a, const void *b) {
+  const heatmap_entry_t *x = a;
+  const heatmap_entry_t *y = b;
+  uint64_t totalX = x->reads + x->writes;
+  uint64_t totalY = y->reads + y->writes;
+  if (totalX != totalY) {
+    return totalX > totalY ? -1 : 1;
+  }
+  return x->address < y->address ? -1 : x->address > y->address;
+}
+
+void printHeatmap(heatmap_t *heatmap, profile_t *symbols, uint32_t imageSize,
+                  FILE *out) {
+  heatmap_entry_t lines[HEATMAP_LINES];
+  heatmap_entry_t pages[HEATMAP_PAGES];
+  heatmap_entry_t total = {0, 0, 0};
+  int touched = 0;
+
+  for (int i = 0; i < HEATMAP_PAGES; i++) {
+    heatmap_entry_t page = {i * HEATMAP_PAGE_SIZE, 0, 0};
+    pages[i] = page;
+  }
+  for (int i = 0; i < HEATMAP_LINES; i++) {
+    heatmap_entry_t line = {i * HEATMAP_LINE_SIZE, heatmap->reads[i],
+                            heatmap->writes[i]};
+    if (!line.reads && !line.writes) {
+      continue;
+    }
+    lines[touched++] = line;
+    heatmap_entry_t *page = &pages[line.address / HEATMAP_PAGE_SIZE];
+    page->reads += line.reads;
+    page->writes += line.writes;
+    total.reads += line.reads;
+    total.writes += line.writes;
+  }
+  qsort(lines, touched, sizeof(heatmap_entry_t), compareAccesses);
+  qsort(pages, HEATMAP_PAGES, sizeof(heatmap_entry_t), compareAccesses);
+
+  //the fewest lines which take WORKING_SET_PERCENT of the accesses
+  uint64_t accesses = total.reads + total.writes;
+  uint64_t covered = 0;
+  int hot = 0;
+  while (hot < touched && 100 * covered < WORKING_SET_PERCENT * accesses) {
+    covered += lines[hot].reads + lines[hot].writes;
+    hot++;
+  }
+
+  fprintf(out, "Heatmap: %" PRIu64 " reads, %" PRIu64 " writes, %d lines of "
+          "%d bytes touched\n", total.reads, total.writes, touched,
+          HEATMAP_LINE_SIZE);
+  fprintf(out, "Working set: %d%% of the accesses in %d lines, %d bytes, %s "
+          "the %d KiB L1\n", WORKING_SET_PERCENT, hot,
+          hot * HEATMAP_LINE_SIZE,
+          hot * HEATMAP_LINE_SIZE <= L1_DATA_SIZE ? "fits in" : "exceeds",
+          L1_DATA_SIZE / 1024);
+
+  fprintf(out, "%-10s %12s %12s\n", "Page", "Reads", "Writes");
+  for (int i = 0; i < HEATMAP_PAGES && pages[i].reads + pages[i].writes;
+       i++) {
+    fprintf(out, "0x%.8x %12" PRIu64 " %12" PRIu64 "\n", pages[i].address,
+            pages[i].reads, pages[i].writes);
+  }
+
+  fprintf(out, "%-10s %12s %12s %7s  %s\n", "Line", "Reads", "Writes", "%",
+          "Location");
+  for (int i = 0; i < touched && i < HEATMAP_TOP_LINES; i++) {
+    fprintf(out, "0x%.8x %12" PRIu64 " %12" PRIu64 " %6.2f%%",
+            lines[i].address, lines[i].reads, lines[i].writes,
+            100.0 * (lines[i].reads + lines[i].writes) / accesses);
+    if (lines[i].address < imageSize) {
+      printLocation(symbols, lines[i].address, out);
+    } else {
+      fprintf(out, "\n");
+    }
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "profile.h"
+
+#define HEATMAP_LINE_SIZE 32 // bytes in an ARM1176 cache line
+#define HEATMAP_PAGE_SIZE 4096
+#define HEATMAP_LINES (MEM_SIZE_WORDS * 4 / HEATMAP_LINE_SIZE)
+#define HEATMAP_PAGES (MEM_SIZE_WORDS * 4 / HEATMAP_PAGE_SIZE)
+#define L1_DATA_SIZE (16 * 1024)
+#define WORKING_SET_PERCENT 90 // of the accesses in the hot working set
+#define HEATMAP_TOP_LINES 20
+#define HEATMAP_SUFFIX ".heat"
+#define HEATMAP_MAGIC "ARMHEAT"
+#define HEATMAP_MAGIC_LENGTH 8 // with the terminating 0
+#define HEATMAP_VERSION 1
+
+/*-------------TypeDefinitions------------------*/
+typedef struct heatmap_entry heatmap_entry_t;
+
+/*-------------Defining the heatmap-------------*/
+struct heatmap_entry {
+  uint32_t address;
+  uint64_t reads;
+  uint64_t writes;
+};
+
+struct heatmap {
+  uint64_t reads[HEATMAP_LINES];
+  uint64_t writes[HEATMAP_LINES];
+};
+
+/*------------------Prototypes-------------------*/
+heatmap_t *createHeatmap(void);
+/*returns a heatmap with every counter at 0*/
+
+static inline void heatmapAccess(heatmap_t *heatmap, int address,
+                                 bool write) {
+  //an unaligned word can straddle two lines
+  int first = address / HEATMAP_LINE_SIZE;
+  int last = (address + 3) / HEATMAP_LINE_SIZE;
+  for (int line = first; line <= last; line++) {
+    if (line >= 0 && line < HEATMAP_LINES) {
+      if (write) {
+        heatmap->writes[line]++;
+      } else {
+        heatmap->reads[line]++;
+      }
+    }
+  }
+}
+/*counts a load or store of the word at the byte address*/
+
+bool writeHeatmap(heatmap_t *heatmap, const char *path);
+/*writes HEATMAP_MAGIC, then HEATMAP_VERSION, HEATMAP_LINE_SIZE and
+  HEATMAP_LINES as 32 bit words, then the reads and writes of every line as
+  64 bit words, all little endian. Returns false if path can't be written*/
+
+void printHeatmap(heatmap_t *heatmap, profile_t *symbols, uint32_t imageSize,
+                  FILE *out);
+/*prints the accesses of every page, the HEATMAP_TOP_LINES hottest lines with
+  their labels in symbols if they are in the first imageSize bytes, and the
+  size of the lines which take WORKING_SET_PERCENT of the accesses against
+  the L1 data cache*/
+
+#endif
@@ -0,0 +1,338 @@
+#include "lexer.h"
+
+// --------------------GLOBAL VARIABLES--------------------------
+static token endOfLine = {"", 0, END_OF_LINE, 0};
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+// ---------------------------LEXER-------------------------------
+static bool isDelimiter(char c) {
+  return c != '\0' && strchr(DELIMITERS, c);
+}
+
+static bool isPunctuation(char c) {
+  return c == '[' || c == ']';
+}
+
+tokenList tokenise(const char *line, int length) {
+  tokenList tokens;
+  bool seenInstruction = false;
+  int i = 0;
+
+  tokens.size     = 0;
+  tokens.position = 0;
+
+  while (i < length && line[i] != '\0' && line[i] != COMMENT_START) {
+    if (isDelimiter(line[i])) {
+      i++;
+      continue;
+    }
+
+    int start = i;
+
+    if (tokens.size == MAX_TOKENS - 1) {
+      // no space left, the rest of the line becomes one undefined token
+      while (i < length && line[i] != '\0' && line[i] != '\n') {
+        i++;
+      }
+      token rest = {line + start, i - start, UNDEFINED, 0};
+      tokens.tokens[tokens.size++] = rest;
+      break;
+    }
+
+    if (isPunctuation(line[i]) || line[i] == '-') {
+      i++;
+    } else {
+      while (i < length && line[i] != '\0' && !isDelimiter(line[i]) &&
+             !isPunctuation(line[i]) && line[i] != COMMENT_START) {
+        i++;
+      }
+    }
+
+    token *t  = &tokens.tokens[tokens.size++];
+    mnemonic m;
+    t->start  = line + start;
+    t->length = i - start;
+    t->type   = getType(t->start, t->length, &t->value, &m);
+
+    if (t->type == INSTRUCTION) {
+      uint32_t *shift = getSlice(SHIFTS, t->start, t->length);
+
+      t->baseLength = m.length;
+      t->condition  = *getSlice(CONDITIONS, m.condition, m.conditionLength);
+      t->setFlags   = m.setFlags;
+
+      if (seenInstruction && shift) {
+        // a shift mnemonic in the operands of an instruction
+        t->type  = SHIFT;
+        t->value = *shift;
+      }
+      seenInstruction = true;
+    }
+  }
+
+  return tokens;
+}
+
+tokenList rewriteTokens(const token prefix[], int n, tokenList *rest) {
+  tokenList tokens;
+
+  tokens.size     = 0;
+  tokens.position = 0;
+
+  for (int i = 0; i < n; i++) {
+    tokens.tokens[tokens.size++] = prefix[i];
+  }
+
+  for (int i = rest ? rest->position : 0;
+       rest && i < rest->size && tokens.size < MAX_TOKENS; i++) {
+    tokens.tokens[tokens.size++] = rest->tokens[i];
+  }
+
+  return tokens;
+}
+
+void syncRewrittenTokens(tokenList *rest, const tokenList *rewritten, int n) {
+  if (rewritten->position > n) {
+    rest->position += rewritten->position - n;
+  }
+}
+
+token *peekToken(tokenList *tokens) {
+  return hasTokens(tokens) ? &tokens->tokens[tokens->position] : &endOfLine;
+}
+
+token *nextToken(tokenList *tokens) {
+  token *t = peekToken(tokens);
+
+  if (hasTokens(tokens)) {
+    tokens->position++;
+  }
+
+  return t;
+}
+
+bool hasTokens(tokenList *tokens) {
+  return tokens->position < tokens->size;
+}
+
+bool tokenIs(const token *t, const char *text) {
+  return !strncmp(t->start, text, t->length) && text[t->length] == '\0';
+}
+
+// -------------------------MNEMONICS-----------------------------
+/* Parses the suffixes of a base instruction of the class into m */
+static bool splitSuffixes(const char *start, int length, uint32_t class,
+                          mnemonic *m) {
+  bool flags = class == 0 || class == 1 || class == 4;
+
+  m->condition = start;
+  m->conditionLength = length;
+  m->setFlags = false;
+  if (getSlice(CONDITIONS, start, length)) {
+    return true;
+  }
+  if (!flags || !length) {
+    return false;
+  }
+
+  // S before or after the condition
+  m->setFlags = true;
+  m->conditionLength = length - 1;
+  if (start[0] == SET_FLAGS_SUFFIX) {
+    m->condition = start + 1;
+    return getSlice(CONDITIONS, start + 1, length - 1);
+  }
+  return start[length - 1] == SET_FLAGS_SUFFIX &&
+         getSlice(CONDITIONS, start, length - 1);
+}
+
+bool splitMnemonic(const char *start, int length, mnemonic *m) {
+  // andeq and the directives are only ever written as they are
+  for (int base = 1; base < length && base < MAX_MNEMONIC_LENGTH; base++) {
+    uint32_t *class = getSlice(ALL_INSTRUCTIONS, start, base);
+    if (class && *class < 5 &&
+        splitSuffixes(start + base, length - base, *class, m)) {
+      m->length = base;
+      return true;
+    }
+  }
+
+  m->length = length;
+  m->condition = start + length;
+  m->conditionLength = 0;
+  m->setFlags = false;
+  return getSlice(ALL_INSTRUCTIONS, start, length);
+}
+
+bool mnemonicIs(const token *instruction, const char *base) {
+  return !strncmp(instruction->start, base, instruction->baseLength) &&
+         base[instruction->baseLength] == '\0';
+}
+
+uint32_t conditionCode(const token *instruction) {
+  return instruction->condition;
+}
+
+token renameInstruction(const token *instruction, const char *base,
+                        bool keepFlags, char text[MAX_MNEMONIC_LENGTH]) {
+  const char *condition = instruction->start + instruction->baseLength;
+  int conditionLength = instruction->length - instruction->baseLength;
+  int length = strlen(base);
+
+  // no condition starts with an s, so a leading s is the S suffix
+  if (instruction->setFlags) {
+    conditionLength--;
+    condition += condition[0] == SET_FLAGS_SUFFIX;
+  }
+
+  memcpy(text, base, length);
+  if (keepFlags && instruction->setFlags) {
+    text[length++] = SET_FLAGS_SUFFIX;
+  }
+  memcpy(text + length, condition, conditionLength);
+  length += conditionLength;
+  text[length] = '\0';
+
+  token renamed = {text, length, INSTRUCTION,
+                   *getSlice(ALL_INSTRUCTIONS, base, strlen(base)),
+                   strlen(base), instruction->condition,
+                   keepFlags && instruction->setFlags};
+  return renamed;
+}
+
+// ---------------------TYPE FUNCTIONS-------------------------
+typeEnum getType(const char *start, int length, int32_t *value,
+                 mnemonic *m) {
+  uint32_t *code;
+
+  *value = 0;
+
+  if (!length) {
+    return UNDEFINED;
+  }
+
+  if (length == 1) {
+    switch (start[0]) {
+      case '[': return OPEN_BRACKET;
+      case ']': return CLOSE_BRACKET;
+      case '-': return MINUS;
+    }
+  }
+
+  if (isLabel(start, length)) {
+    return LABEL;
+  }
+
+  typeEnum expression = isExpression(start, length, value);
+  if (expression != UNDEFINED) {
+    return expression;
+  }
+
+  if (splitMnemonic(start, length, m)) {
+    // the whole mnemonic first, andeq is not an and
+    if (!(code = getSlice(ALL_INSTRUCTIONS, start, length))) {
+      code = getSlice(ALL_INSTRUCTIONS, start, m->length);
+    }
+    *value = *code;
+    return INSTRUCTION;
+  }
+
+  if (isRegister(start, length, value)) {
+    return REGISTER;
+  }
+
+  return UNDEFINED;
+}
+
+bool isRegister(const char *start, int length, int32_t *value) {
+  if (length < 2 || length > 3 || start[0] != 'r') {
+    return false;
+  }
+
+  for (int i = 1; i < length; i++) {
+    if (start[i] < '0' || start[i] > '9') {
+      return false;
+    }
+  }
+
+  int number = getDec(start + 1, length - 1);
+  *value = number;
+  return number >= 0 && number <= 16;
+}
+
+bool isLabel(const char *start, int length) {
+  return start[length - 1] == ':';
+}
+
+typeEnum isExpression(const char *start, int length, int32_t *value) {
+  if (start[0] != '#' && start[0] != '=') {
+    return UNDEFINED;
+  }
+
+  int i = 1;
+  bool negative = false;
+  if (i < length && start[i] == '-') {
+    negative = true;
+    i++;
+  }
+
+  if (length >= i + 3 && start[i] == '0' && start[i + 1] == 'x') {
+    // we might have a hex value
+    for (int j = i + 2; j < length; j++) {
+      if ((start[j] < '0' || start[j] > '9') &&
+          (start[j] < 'a' || start[j] > 'f') &&
+          (start[j] < 'A' || start[j] > 'F')) {
+        return UNDEFINED;
+      }
+    }
+    *value = getHex(start + i + 2, length - i - 2);
+  } else {
+    // we might have a decimal value
+    if (i == length) {
+      return UNDEFINED;
+    }
+
+    for (int j = i; j < length; j++) {
+      if (start[j] < '0' || start[j] > '9') {
+        return UNDEFINED;
+      }
+    }
+    *value = getDec(start + i, length - i);
+  }
+
+  if (negative) {
+    *value = -*value;
+  }
+
+  return start[0] == '#' ? EXPRESSION_TAG : EXPRESSION_EQUAL;
+}
+
+// ----------------------GET FUNCTIONS-------------------------
+int32_t getHex(const char *start, int length) {
+  uint32_t res = 0;
+
+  for (int i = 0; i < length; i++) {
+    int x;
+    if (start[i] >= 'A' && start[i] <= 'F') {
+      x = start[i] - 'A' + 10;
+    } else if (start[i] >= 'a' && start[i] <= 'f') {
+      x = start[i] - 'a' + 10;
+    } else {
+      x = start[i] - '0';
+    }
+    res <<= 4;
+    res |= x;
+  }
+
+  return res;
+}
+
+int32_t getDec(const char *start, int length) {
+  uint32_t res = 0;
+
+  for (int i = 0; i < length; i++) {
+    res = res * 10 + (start[i] - '0');
+  }
+
+  return res;
+}
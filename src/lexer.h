@@ -0,0 +1,137 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include "mappings.h"
+
+// ---------------------------MACROS-----------------------------
+#define MAX_TOKENS 32
+#define DELIMITERS " ,\t\r\n"
+#define COMMENT_START '@'
+#define MAX_MNEMONIC_LENGTH 8
+#define SET_FLAGS_SUFFIX 's'
+
+// -------------------------TYPES---------------------------------
+typedef struct token token;
+typedef struct tokenList tokenList;
+typedef struct mnemonic mnemonic;
+
+// -------------------------STRUCTS-------------------------------
+/**
+* A token is a slice of the line it was read from, it is never copied or
+* null terminated. The type is computed once by the lexer and value holds
+* the already parsed payload of the token:
+* REGISTER          the register number
+* EXPRESSION_*      the numeric value of the expression
+* SHIFT             the shift code from SHIFTS
+* INSTRUCTION       the instruction class from ALL_INSTRUCTIONS
+* An INSTRUCTION also keeps its mnemonic split once by the lexer: the length
+* of the base instruction, the code of its condition and its S suffix
+**/
+struct token {
+  const char *start;
+  int        length;
+  typeEnum   type;
+  int32_t    value;
+  int        baseLength;
+  uint32_t   condition;
+  bool       setFlags;
+};
+
+struct tokenList {
+  token tokens[MAX_TOKENS];
+  int   size;
+  int   position;
+};
+
+/**
+* An instruction mnemonic split in the base instruction (its first length
+* characters), the condition suffix (empty if there is none) and the S
+* suffix. Both suffix orders are accepted (eg. addseq and addeqs)
+**/
+struct mnemonic {
+  int        length;
+  const char *condition;
+  int        conditionLength;
+  bool       setFlags;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+// ---------------------------LEXER-------------------------------
+/**
+* Splits the first length characters of line into typed tokens with
+* respect to DELIMITERS. Everything after a COMMENT_START is ignored.
+* Square brackets and a leading minus sign are tokens on their own.
+* The first mnemonic of a statement is an INSTRUCTION, any later shift
+* mnemonic is a SHIFT (eg. mov r1, r2, lsl #2)
+**/
+tokenList tokenise(const char *line, int length);
+
+/**
+* Builds a new token list from the prefix tokens followed by all the
+* remaining tokens of rest, if rest is not NULL. Used to rewrite an
+* instruction as another one
+* (eg. lsl Rn, <#expression> as mov Rn, Rn, lsl <#expression>)
+**/
+tokenList rewriteTokens(const token prefix[], int n, tokenList *rest);
+
+/**
+* Marks every token of rest which was consumed through the list built by
+* rewriteTokens(prefix, n, rest) as consumed
+**/
+void syncRewrittenTokens(tokenList *rest, const tokenList *rewritten, int n);
+
+/* Returns the current token or an END_OF_LINE token if there is none */
+token *peekToken(tokenList *tokens);
+
+/* Returns the current token and advances to the next one */
+token *nextToken(tokenList *tokens);
+
+/* Returns true iff there are tokens left to consume */
+bool hasTokens(tokenList *tokens);
+
+/* Returns true iff the text of the token is exactly text */
+bool tokenIs(const token *t, const char *text);
+
+// -------------------------MNEMONICS-----------------------------
+/**
+* Splits the slice in its base instruction and suffixes. The S suffix is
+* only accepted by data processing, multiply and shift instructions
+* Returns false if the slice is not a possibly suffixed instruction
+**/
+bool splitMnemonic(const char *start, int length, mnemonic *m);
+
+/* Returns true iff the base instruction of the token is base */
+bool mnemonicIs(const token *instruction, const char *base);
+
+/* Returns the code of the condition of the instruction from CONDITIONS */
+uint32_t conditionCode(const token *instruction);
+
+/**
+* Returns the instruction token for base with the condition of instruction,
+* and its S suffix if keepFlags (eg. moveq for lsleq). The mnemonic is
+* written to text which must hold MAX_MNEMONIC_LENGTH characters
+**/
+token renameInstruction(const token *instruction, const char *base,
+                        bool keepFlags, char text[MAX_MNEMONIC_LENGTH]);
+
+// ---------------------TYPE FUNCTIONS-------------------------
+/**
+* Returns the type of the slice and parses its value through value
+* The mnemonic of an INSTRUCTION is returned through m
+**/
+typeEnum getType(const char *start, int length, int32_t *value,
+                 mnemonic *m);
+
+/* Helpers for type */
+bool isLabel(const char *start, int length);
+bool isRegister(const char *start, int length, int32_t *value);
+typeEnum isExpression(const char *start, int length, int32_t *value);
+
+// ----------------------GET FUNCTIONS-------------------------
+/* Gets hexadecimal value from the slice (without the 0x prefix) */
+int32_t getHex(const char *start, int length);
+
+/* Gets decimal value from the slice */
+int32_t getDec(const char *start, int length);
+
+#endif
@@ -0,0 +1,143 @@
+#include "linecache.h"
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+lineCache constructLineCache(void) {
+  lineCache c = {NULL, 0, 0};
+  return c;
+}
+
+uint64_t lineKey(const char *text, int length, int32_t dependency) {
+  uint64_t hash = 14695981039346656037ULL;
+
+  for (int i = 0; i < length; i++) {
+    hash ^= (unsigned char) text[i];
+    hash *= 1099511628211ULL;
+  }
+  for (int i = 0; i < 4; i++) {
+    hash ^= ((uint32_t) dependency >> (8 * i)) & 0xFF;
+    hash *= 1099511628211ULL;
+  }
+
+  // EMPTY_KEY marks the free slots
+  return hash == EMPTY_KEY ? 1 : hash;
+}
+
+static cacheEntry *findSlot(const lineCache *c, uint64_t key) {
+  uint32_t i = key & (c->capacity - 1);
+
+  while (c->entries[i].key != EMPTY_KEY && c->entries[i].key != key) {
+    i = (i + 1) & (c->capacity - 1);
+  }
+
+  return &c->entries[i];
+}
+
+static void growLineCache(lineCache *c) {
+  lineCache grown;
+  grown.size     = 0;
+  grown.capacity = c->capacity ? 2 * c->capacity : LINE_CACHE_MIN_CAPACITY;
+  grown.entries  = calloc(grown.capacity, sizeof(cacheEntry));
+
+  if (!grown.entries) {
+    fprintf(stderr, "The calloc from the growLineCache function has failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (uint32_t i = 0; i < c->capacity; i++) {
+    if (c->entries[i].key != EMPTY_KEY) {
+      cacheWord(&grown, c->entries[i].key, c->entries[i].word);
+    }
+  }
+
+  free(c->entries);
+  *c = grown;
+}
+
+bool findCachedWord(const lineCache *c, uint64_t key, uint32_t *word) {
+  if (!c->size) {
+    return false;
+  }
+
+  cacheEntry *entry = findSlot(c, key);
+  *word = entry->word;
+  return entry->key == key;
+}
+
+void cacheWord(lineCache *c, uint64_t key, uint32_t word) {
+  // keep at least half of the slots free
+  if (2 * (c->size + 1) > c->capacity) {
+    growLineCache(c);
+  }
+
+  cacheEntry *entry = findSlot(c, key);
+  if (entry->key == EMPTY_KEY) {
+    entry->key = key;
+    c->size++;
+  }
+  entry->word = word;
+}
+
+void mergeLineCache(lineCache *into, const lineCache *from) {
+  for (uint32_t i = 0; i < from->capacity; i++) {
+    if (from->entries[i].key != EMPTY_KEY) {
+      cacheWord(into, from->entries[i].key, from->entries[i].word);
+    }
+  }
+}
+
+bool loadLineCache(const char *path, lineCache *c) {
+  FILE *file = fopen(path, "rb");
+  uint32_t header[3];
+
+  *c = constructLineCache();
+  if (!file) {
+    return false;
+  }
+
+  // header: magic, version and number of entries
+  if (fread(header, sizeof(uint32_t), 3, file) != 3 ||
+      header[0] != LINE_CACHE_MAGIC || header[1] != LINE_CACHE_VERSION) {
+    fclose(file);
+    return false;
+  }
+
+  for (uint32_t i = 0; i < header[2]; i++) {
+    cacheEntry entry;
+    if (fread(&entry.key, sizeof(uint64_t), 1, file) != 1 ||
+        fread(&entry.word, sizeof(uint32_t), 1, file) != 1 ||
+        entry.key == EMPTY_KEY) {
+      // truncated or corrupt cache, start again from an empty one
+      clearLineCache(c);
+      fclose(file);
+      return false;
+    }
+    cacheWord(c, entry.key, entry.word);
+  }
+
+  fclose(file);
+  return true;
+}
+
+bool saveLineCache(const char *path, const lineCache *c) {
+  FILE *file = fopen(path, "wb");
+  uint32_t header[3] = {LINE_CACHE_MAGIC, LINE_CACHE_VERSION, c->size};
+
+  if (!file) {
+    return false;
+  }
+
+  bool written = fwrite(header, sizeof(uint32_t), 3, file) == 3;
+  for (uint32_t i = 0; written && i < c->capacity; i++) {
+    if (c->entries[i].key != EMPTY_KEY) {
+      written = fwrite(&c->entries[i].key, sizeof(uint64_t), 1, file) == 1 &&
+                fwrite(&c->entries[i].word, sizeof(uint32_t), 1, file) == 1;
+    }
+  }
+
+  return !fclose(file) && written;
+}
+
+void clearLineCache(lineCache *c) {
+  free(c->entries);
+  *c = constructLineCache();
+}
@@ -0,0 +1,71 @@
+#ifndef LINECACHE_H
+#define LINECACHE_H
+
+#include "headers.h"
+
+// ---------------------------MACROS-----------------------------
+#define LINE_CACHE_MAGIC 0x434D5241
+#define LINE_CACHE_VERSION 1
+#define LINE_CACHE_MIN_CAPACITY 1024
+#define EMPTY_KEY 0
+
+// -------------------------TYPES---------------------------------
+typedef struct cacheEntry cacheEntry;
+typedef struct lineCache lineCache;
+
+// -------------------------STRUCTS-------------------------------
+struct cacheEntry {
+  uint64_t key;
+  uint32_t word;
+};
+
+/**
+* Maps the key of an instruction (see lineKey) to its encoding. The entries
+* are an open addressing table of capacity slots, a power of two, where
+* the free slots have the key EMPTY_KEY
+**/
+struct lineCache {
+  cacheEntry *entries;
+  uint32_t   size;
+  uint32_t   capacity;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+/* Constructor function that will return an empty cache */
+lineCache constructLineCache(void);
+
+/**
+* Returns the key of the instruction written as the length characters of
+* text whose encoding also depends on dependency (eg. the distance to the
+* label it branches to)
+**/
+uint64_t lineKey(const char *text, int length, int32_t dependency);
+
+/**
+* Looks key up in the cache, the encoding is returned through word
+* Only reads the cache so any number of threads can search it at once
+**/
+bool findCachedWord(const lineCache *c, uint64_t key, uint32_t *word);
+
+/* Adds the encoding word of key to the cache */
+void cacheWord(lineCache *c, uint64_t key, uint32_t word);
+
+/* Adds every entry of from to into */
+void mergeLineCache(lineCache *into, const lineCache *from);
+
+/**
+* Reads the cache saved at path into c
+* Returns false if there is no valid cache at path, c is left empty
+**/
+bool loadLineCache(const char *path, lineCache *c);
+
+/**
+* Writes the cache to path
+* Returns false if the file couldn't be written
+**/
+bool saveLineCache(const char *path, const lineCache *c);
+
+/* Frees the entries of the cache */
+void clearLineCache(lineCache *c);
+
+#endif
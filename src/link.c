@@ -0,0 +1,146 @@
+#include "link.h"
+
+int main(int argc, char **argv) {
+  // Check for number of arguments
+  if (argc < 3) {
+    fprintf(stderr, "The function needs at least 2 arguments!");
+    exit(EXIT_FAILURE);
+  }
+
+  int count = argc - 2;
+  char *imagePath = argv[argc - 1];
+  arena runArena = constructArena(ARENA_BLOCK_SIZE);
+  vector errorVector = constructVectorInArena(&runArena);
+  objectFile *objects = allocate(&runArena, count * sizeof(objectFile));
+
+  for (int i = 0; i < count; i++) {
+    objects[i] = constructObjectFile(&runArena);
+    if (!readObjectFile(argv[i + 1], &objects[i])) {
+      throwLinkError(&errorVector, argv[i + 1], "The file is not an object.");
+    }
+  }
+
+  // the whole image is kept in memory until every relocation is applied
+  outputWriter image = constructOutputWriter(imagePath, KEEP_ALL_WORDS);
+  if (isEmptyVector(errorVector)) {
+    linkObjects(objects, argv + 1, count, &image, &errorVector, &runArena);
+  }
+
+  for (int i = 0; i < count; i++) {
+    clearObjectFile(&objects[i]);
+  }
+
+  // if we have link erros stop and print errors
+  if (!isEmptyVector(errorVector)) {
+    while (!isEmptyVector(errorVector)) {
+      fprintf(stderr, "%s\n", getFront(&errorVector));
+    }
+
+    discardOutputWriter(&image);
+    clearArena(&runArena);
+    exit(EXIT_FAILURE);
+  }
+
+  clearArena(&runArena);
+  if (!closeOutputWriter(&image)) {
+    fprintf(stderr, "The file %s could not be written\n", imagePath);
+    exit(EXIT_FAILURE);
+  }
+  exit(EXIT_SUCCESS);
+}
+
+void linkObjects(objectFile *objects, char **paths, int count,
+                 outputWriter *image, vector *errorVector, arena *pool) {
+  uint32_t *codeBases = allocate(pool, count * sizeof(uint32_t));
+  map symbols = constructMapInArena(pool);
+  uint32_t imageSize = 0;
+
+  // every module is followed by its own last pool, so its loads only reach
+  // as far as they would if the module ended with .ltorg
+  for (int i = 0; i < count; i++) {
+    codeBases[i] = imageSize;
+    imageSize += objects[i].code.size + objects[i].literals.size;
+  }
+
+  // map every exported label to its address in the image
+  for (int i = 0; i < count; i++) {
+    for (int j = 0; j < objects[i].symbolCount; j++) {
+      symbol *s = &objects[i].symbols[j];
+      if (!s->defined) {
+        continue;
+      }
+      if (get(symbols, s->name)) {
+        throwLinkError(errorVector, paths[i],
+                       "Multiple definitions of the same label: %s.", s->name);
+      } else {
+        put(&symbols, s->name, codeBases[i] + s->value);
+      }
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    for (int j = 0; j < objects[i].code.size; j++) {
+      emitWord(image, objects[i].code.values[j]);
+    }
+    for (int j = 0; j < objects[i].literals.size; j++) {
+      emitWord(image, objects[i].literals.values[j]);
+    }
+  }
+
+  for (int i = 0; i < count; i++) {
+    relocate(&objects[i], paths[i], codeBases[i],
+             codeBases[i] + objects[i].code.size, symbols, image,
+             errorVector);
+  }
+
+  clearMap(&symbols);
+}
+
+void relocate(objectFile *object, char *path, uint32_t codeBase,
+              uint32_t poolStart, map symbols, outputWriter *image,
+              vector *errorVector) {
+  for (int i = 0; i < object->relocationCount; i++) {
+    relocation *r = &object->relocations[i];
+    uint32_t instruction = codeBase + r->instruction;
+
+    if (r->instruction >= (uint32_t) object->code.size) {
+      throwLinkError(errorVector, path, "Invalid relocation %d.", i);
+    } else if (r->kind == BRANCH_RELOCATION) {
+      uint32_t *target = NULL;
+      if (r->target >= (uint32_t) object->symbolCount) {
+        throwLinkError(errorVector, path, "Invalid relocation %d.", i);
+      } else if (!(target = get(symbols, object->symbols[r->target].name))) {
+        throwLinkError(errorVector, path, "Undefined label %s.",
+                       object->symbols[r->target].name);
+      } else {
+        patchWord(image, instruction, BRANCH_OFFSET_MASK,
+                  branchOffset(instruction, *target));
+      }
+    } else if (r->target >= (uint32_t) object->literals.size) {
+      throwLinkError(errorVector, path, "Invalid relocation %d.", i);
+    } else {
+      int32_t offset = literalOffset(instruction, poolStart + r->target);
+      if (!literalInRange(offset)) {
+        throwLinkError(errorVector, path,
+                       "The literal pool is out of range of the load %u.",
+                       r->instruction);
+      } else {
+        patchWord(image, instruction, LITERAL_FIELD_MASK,
+                  literalField(offset));
+      }
+    }
+  }
+}
+
+// ---------------------------ERRORS------------------------------
+void throwLinkError(vector *errorVector, char *path, const char *format, ...) {
+  char error[MAX_ERROR_LENGTH];
+  int length = snprintf(error, MAX_ERROR_LENGTH, "[%s] ", path);
+  va_list args;
+
+  va_start(args, format);
+  vsnprintf(error + length, MAX_ERROR_LENGTH - length, format, args);
+  va_end(args);
+
+  putBack(errorVector, error);
+}
@@ -0,0 +1,32 @@
+#include "object.h"
+#include "fixup.h"
+#include "literals.h"
+#include <stdarg.h>
+
+// ---------------------------MACROS-----------------------------
+#define MAX_ERROR_LENGTH 200
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+/**
+* Places the count objects read from paths in the image in order, the code
+* of every object followed by its last pool.
+* Resolves the branches between the objects and the literal loads
+* Throws an error for every label exported twice or not exported at all and
+* for every relocation which can't be applied
+* The symbol table is allocated from pool
+**/
+void linkObjects(objectFile *objects, char **paths, int count,
+                 outputWriter *image, vector *errorVector, arena *pool);
+
+/**
+* Applies the relocations of the object whose code starts at codeBase and
+* whose last pool starts at poolStart, symbols maps every label to its
+* address in the image
+**/
+void relocate(objectFile *object, char *path, uint32_t codeBase,
+              uint32_t poolStart, map symbols, outputWriter *image,
+              vector *errorVector);
+
+// ---------------------------ERRORS------------------------------
+/* Adds the error about the object at path, formatted as printf */
+void throwLinkError(vector *errorVector, char *path, const char *format, ...);
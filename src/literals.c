@@ -0,0 +1,105 @@
+#include "literals.h"
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+static literalPool constructLiteralPool(void) {
+  literalPool pool = {constructArray(), NULL, 0, UNPLACED_POOL};
+  return pool;
+}
+
+static void pushPool(literalPools *p) {
+  if (p->size == p->capacity) {
+    p->capacity = p->capacity ? 2 * p->capacity : POOL_MIN_CAPACITY;
+    literalPool *pools = realloc(p->pools, p->capacity * sizeof(literalPool));
+    if (!pools) {
+      perror("realloc");
+      exit(EXIT_FAILURE);
+    }
+    p->pools = pools;
+  }
+
+  p->pools[p->size++] = constructLiteralPool();
+}
+
+literalPools constructLiteralPools(void) {
+  literalPools p = {NULL, 0, 0};
+  pushPool(&p);
+  return p;
+}
+
+void clearLiteralPools(literalPools *p) {
+  for (int i = 0; i < p->size; i++) {
+    clearArray(&p->pools[i].values);
+    free(p->pools[i].slots);
+  }
+  free(p->pools);
+  p->pools = NULL;
+  p->size = 0;
+  p->capacity = 0;
+}
+
+literalPool *currentPool(literalPools *p) {
+  return &p->pools[p->size - 1];
+}
+
+literalPool *placePool(literalPools *p, uint32_t start) {
+  currentPool(p)->start = start;
+  pushPool(p);
+  return &p->pools[p->size - 2];
+}
+
+static uint32_t *findEntry(const literalPool *pool, uint32_t value) {
+  uint32_t i = (value * 2654435761u) & (pool->capacity - 1);
+
+  while (pool->slots[i] != NO_SLOT &&
+         pool->values.values[pool->slots[i] - 1] != value) {
+    i = (i + 1) & (pool->capacity - 1);
+  }
+
+  return &pool->slots[i];
+}
+
+static void growPool(literalPool *pool) {
+  free(pool->slots);
+  pool->capacity = pool->capacity ? 2 * pool->capacity : POOL_MIN_CAPACITY;
+  pool->slots = calloc(pool->capacity, sizeof(uint32_t));
+
+  if (!pool->slots) {
+    fprintf(stderr, "The calloc from the growPool function has failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for (int i = 0; i < pool->values.size; i++) {
+    *findEntry(pool, pool->values.values[i]) = i + 1;
+  }
+}
+
+uint32_t addLiteral(literalPool *pool, uint32_t value) {
+  uint32_t slot;
+
+  if (findLiteral(pool, value, &slot)) {
+    return slot;
+  }
+
+  append(&pool->values, value);
+  // keep at least half of the entries free
+  if (2 * (uint32_t) pool->values.size > pool->capacity) {
+    growPool(pool);
+  } else {
+    *findEntry(pool, value) = pool->values.size;
+  }
+  return pool->values.size - 1;
+}
+
+bool findLiteral(const literalPool *pool, uint32_t value, uint32_t *slot) {
+  if (!pool->capacity) {
+    return false;
+  }
+
+  uint32_t entry = *findEntry(pool, value);
+  *slot = entry - 1;
+  return entry != NO_SLOT;
+}
+
+uint32_t poolSize(const literalPool *pool) {
+  return pool->values.size;
+}
@@ -0,0 +1,68 @@
+#ifndef LITERALS_H
+#define LITERALS_H
+
+#include "adts.h"
+
+// ---------------------------MACROS-----------------------------
+#define UNPLACED_POOL UINT32_MAX
+#define POOL_MIN_CAPACITY 16
+#define NO_SLOT 0
+
+// -------------------------TYPES---------------------------------
+typedef struct literalPool literalPool;
+typedef struct literalPools literalPools;
+
+// -------------------------STRUCTS-------------------------------
+/**
+* The constants loaded by ldr Rd, =<expression> which don't fit in a mov.
+* Every constant has a single slot: values holds them in slot order and
+* slots is an open addressing index of capacity entries from a constant to
+* its slot + 1 (NO_SLOT when the entry is free). start is the address of
+* the first slot or UNPLACED_POOL if the pool hasn't been placed yet
+**/
+struct literalPool {
+  array    values;
+  uint32_t *slots;
+  uint32_t capacity;
+  uint32_t start;
+};
+
+/**
+* The pools of a program in address order: one for every .ltorg and the
+* last one at the end of the program
+**/
+struct literalPools {
+  literalPool *pools;
+  int         size;
+  int         capacity;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+/* Constructor function that will return a list with one empty pool */
+literalPools constructLiteralPools(void);
+
+/* Frees all the pools */
+void clearLiteralPools(literalPools *p);
+
+/* Returns the last pool, the one being filled */
+literalPool *currentPool(literalPools *p);
+
+/**
+* Places the current pool at start and starts a new one after it
+* Returns the placed pool
+**/
+literalPool *placePool(literalPools *p, uint32_t start);
+
+/* Returns the slot of value in the pool, adding it if it's not there yet */
+uint32_t addLiteral(literalPool *pool, uint32_t value);
+
+/**
+* Looks value up in the pool, its slot is returned through slot
+* Only reads the pool so any number of threads can search it at once
+**/
+bool findLiteral(const literalPool *pool, uint32_t value, uint32_t *slot);
+
+/* Returns the number of slots of the pool */
+uint32_t poolSize(const literalPool *pool);
+
+#endif
@@ -0,0 +1,136 @@
+#include "live.h"
+
+live_t *openLive(const char *name) {
+  live_t *live = calloc(1, sizeof(live_t));
+  if (!live) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  if (!*name) {
+    snprintf(live->name, MAX_LIVE_NAME_LENGTH, LIVE_NAME_FORMAT, getpid());
+  } else {
+    //shm_open wants a single leading slash
+    snprintf(live->name, MAX_LIVE_NAME_LENGTH, "%s%s",
+             *name == '/' ? "" : "/", name);
+  }
+
+  int fd = shm_open(live->name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    free(live);
+    return NULL;
+  }
+  if (ftruncate(fd, sizeof(live_block_t))) {
+    close(fd);
+    shm_unlink(live->name);
+    free(live);
+    return NULL;
+  }
+  void *block = mmap(NULL, sizeof(live_block_t), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+  close(fd);
+  if (block == MAP_FAILED) {
+    shm_unlink(live->name);
+    free(live);
+    return NULL;
+  }
+
+  live->block = block;
+  live->counts.magic = LIVE_MAGIC;
+  live->counts.version = LIVE_VERSION;
+  live->counts.pid = getpid();
+  live->countdown = LIVE_UPDATE_INSTRUCTIONS;
+  clock_gettime(CLOCK_MONOTONIC, &live->start);
+  live->last = live->start;
+  live->block->version = LIVE_VERSION;
+  live->block->pid = live->counts.pid;
+  __sync_synchronize();
+  //the readers check the magic last
+  live->block->magic = LIVE_MAGIC;
+  fprintf(stderr, "Live metrics in %s\n", live->name);
+  return live;
+}
+
+void closeLive(live_t *live, proc_state_t *pState) {
+  live->counts.finished = 1;
+  live->last = live->start;
+  live->lastRetired = 0;
+  publishLive(live, pState);
+  munmap((void *) live->block, sizeof(live_block_t));
+  shm_unlink(live->name);
+  free(live);
+}
+
+void publishLive(live_t *live, proc_state_t *pState) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double seconds = (now.tv_sec - live->last.tv_sec) +
+                   (now.tv_nsec - live->last.tv_nsec) / 1e9;
+  live_block_t *counts = &live->counts;
+  counts->pc = pState->executing;
+  counts->mips = seconds > 0 ?
+                 (counts->retired - live->lastRetired) / seconds / 1e6 : 0.0;
+  live->last = now;
+  live->lastRetired = counts->retired;
+  live->countdown = LIVE_UPDATE_INSTRUCTIONS;
+
+  volatile live_block_t *block = live->block;
+  counts->sequence = block->sequence + 1;
+  block->sequence = counts->sequence;
+  __sync_synchronize();
+  block->retired = counts->retired;
+  block->pc = counts->pc;
+  block->pins = counts->pins;
+  block->mips = counts->mips;
+  for (int i = 0; i < DEVICES; i++) {
+    block->loads[i] = counts->loads[i];
+    block->stores[i] = counts->stores[i];
+  }
+  block->finished = counts->finished;
+  __sync_synchronize();
+  block->sequence = counts->sequence + 1;
+}
+
+void liveTransfer(live_t *live, int address, bool store, int value) {
+  int device = deviceOf(address);
+  if (device == NO_DEVICE) {
+    return;
+  }
+  if (!store) {
+    live->counts.loads[device]++;
+    return;
+  }
+  live->counts.stores[device]++;
+  if (device == GPIO_ON) {
+    live->counts.pins |= value;
+  } else if (device == GPIO_OFF) {
+    live->counts.pins &= ~value;
+  }
+}
+
+bool readLive(volatile const live_block_t *block, live_block_t *copy) {
+  if (block->magic != LIVE_MAGIC || block->version != LIVE_VERSION) {
+    return false;
+  }
+  uint32_t sequence;
+  do {
+    while ((sequence = block->sequence) & 1) {
+      continue;
+    }
+    __sync_synchronize();
+    copy->retired = block->retired;
+    copy->pc = block->pc;
+    copy->pins = block->pins;
+    copy->mips = block->mips;
+    for (int i = 0; i < DEVICES; i++) {
+      copy->loads[i] = block->loads[i];
+      copy->stores[i] = block->stores[i];
+    }
+    copy->finished = block->finished;
+    __sync_synchronize();
+  } while (block->sequence != sequence);
+  copy->magic = LIVE_MAGIC;
+  copy->version = LIVE_VERSION;
+  copy->pid = block->pid;
+  copy->sequence = sequence;
+  return true;
+}
@@ -0,0 +1,80 @@
+#ifndef LIVE_H
+#define LIVE_H
+
+#include "stats.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define LIVE_MAGIC 0x54534d45 // "EMST"
+#define LIVE_VERSION 1
+#define LIVE_NAME_FORMAT "/emulate.%d" // the default, with the pid
+#define MAX_LIVE_NAME_LENGTH 64
+// the block is written once every this many instructions, about 50ms
+#define LIVE_UPDATE_INSTRUCTIONS (1 << 20)
+
+/*-------------TypeDefinitions------------------*/
+typedef struct live_block live_block_t;
+
+/*-------------Defining the live metrics--------*/
+/*The shared memory segment: only fixed size fields, the version changes
+  with the layout. sequence is odd while the emulator writes the block, a
+  reader copies the block until sequence is even and the same before and
+  after*/
+struct live_block {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t sequence;
+  uint32_t pid;
+  uint64_t retired;
+  uint32_t pc;
+  uint32_t pins; //bit n set when GPIO pin n is on
+  double mips; //since the last update, over the whole run once finished
+  uint64_t loads[DEVICES];
+  uint64_t stores[DEVICES];
+  uint32_t finished;
+  uint32_t padding;
+};
+
+/*The counters of the emulator, copied into the block every
+  LIVE_UPDATE_INSTRUCTIONS so that the run loop only touches its own memory*/
+struct live {
+  volatile live_block_t *block;
+  char name[MAX_LIVE_NAME_LENGTH];
+  live_block_t counts;
+  int countdown;
+  uint64_t lastRetired;
+  struct timespec start;
+  struct timespec last;
+};
+
+/*------------------Prototypes-------------------*/
+live_t *openLive(const char *name);
+/*creates the shared memory segment name, "" for LIVE_NAME_FORMAT, and
+  prints its name. Returns NULL if it can't be created*/
+
+void closeLive(live_t *live, proc_state_t *pState);
+/*publishes the final counters, marks the run finished and removes the
+  segment*/
+
+void publishLive(live_t *live, proc_state_t *pState);
+/*copies the counters and the pc into the shared block*/
+
+void liveTransfer(live_t *live, int address, bool store, int value);
+/*counts an access to an MMIO register, the stores to GPIO_OUTPUT_ON and
+  GPIO_OUTPUT_OFF turn on and off the pins set in value*/
+
+static inline void liveInstruction(live_t *live, proc_state_t *pState,
+                                   bool executed) {
+  live->counts.retired += executed;
+  if (!--live->countdown) {
+    publishLive(live, pState);
+  }
+}
+/*counts an instruction and publishes every LIVE_UPDATE_INSTRUCTIONS*/
+
+bool readLive(volatile const live_block_t *block, live_block_t *copy);
+/*copies a consistent block, returns false if it is not a live block of
+  this version*/
+
+#endif
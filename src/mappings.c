@@ -1,4 +1,14 @@
 #include "mappings.h"
+#include <pthread.h>
+
+// --------------------GLOBAL VARIABLES--------------------------
+map DATA_OPCODE;
+map ALL_INSTRUCTIONS;
+map CONDITIONS;
+map DATA_TYPE;
+map SHIFTS;
+
+static pthread_once_t filled = PTHREAD_ONCE_INIT;
 
 // -------------------FUNCTION DEFINITIONS-----------------------
 map fillDataToOpcode(void) {
@@ -59,6 +69,10 @@ map fillAllInstructions(void) {
   // 5 Special
   put(&m, "andeq", 5);
 
+  // 6 Directives
+  put(&m, ".ltorg", LTORG_DIRECTIVE);
+  put(&m, ".global", GLOBAL_DIRECTIVE);
+
   return m;
 }
 
@@ -71,6 +85,7 @@ map fillConditions(void) {
   put(&m, "lt", 11);
   put(&m, "gt", 12);
   put(&m, "le", 13);
+  put(&m, "al", 14);
   put(&m, "", 14);
 
   return m;
@@ -110,7 +125,7 @@ map fillShifts(void) {
   return m;
 }
 
-void fillAll(void) {
+static void fillMappings(void) {
   DATA_OPCODE      = fillDataToOpcode();
   ALL_INSTRUCTIONS = fillAllInstructions();
   CONDITIONS       = fillConditions();
@@ -118,6 +133,10 @@ void fillAll(void) {
   SHIFTS           = fillShifts();
 }
 
+void fillAll(void) {
+  pthread_once(&filled, fillMappings);
+}
+
 void freeAll(void) {
   clearMap(&DATA_OPCODE);
   clearMap(&ALL_INSTRUCTIONS);
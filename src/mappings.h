@@ -3,6 +3,10 @@
 
 #include "adts.h"
 
+// ---------------------------MACROS-----------------------------
+#define LTORG_DIRECTIVE 6
+#define GLOBAL_DIRECTIVE 7
+
 // -------------------FUNCTION DECLARATIONS-----------------------
 /**
 * Returns a map with all the Data Processing instructions from the assembler
@@ -18,6 +22,10 @@ map fillDataToOpcode(void);
 * 3 Branch
 * 4 Shifts
 * 5 Special andeq r0, r0, r0
+* 6 Directive .ltorg which places the literal pool
+* 7 Directive .global <label> which exports the label to the other modules
+* Any of the first five may be followed by a condition from CONDITIONS and
+* the S suffix (see splitMnemonic)
 **/
 map fillAllInstructions(void);
 
@@ -38,20 +46,25 @@ map fillDataToType(void);
 /* Returns a map with all 4 shifts mapped to their respective code */
 map fillShifts(void);
 
-/* Fills all mappings */
+/**
+* Fills all mappings, only the first call does anything so every thread may
+* call it. After that the maps are only read: lookups never write to a map
+* so any number of threads can use them concurrently
+**/
 void fillAll(void);
 
 /* Frees all mappings */
 void freeAll(void);
 // --------------------------ENUMS-------------------------------
-typedef enum {INSTRUCTION, LABEL, EXPRESSION_TAG,
-              EXPRESSION_EQUAL, REGISTER, UNDEFINED} typeEnum;
+typedef enum {INSTRUCTION, LABEL, EXPRESSION_TAG, EXPRESSION_EQUAL,
+              REGISTER, SHIFT, OPEN_BRACKET, CLOSE_BRACKET, MINUS,
+              UNDEFINED, END_OF_LINE} typeEnum;
 
 // --------------------GLOBAL VARIABLES--------------------------
-map DATA_OPCODE;
-map ALL_INSTRUCTIONS;
-map CONDITIONS;
-map DATA_TYPE;
-map SHIFTS;
+extern map DATA_OPCODE;
+extern map ALL_INSTRUCTIONS;
+extern map CONDITIONS;
+extern map DATA_TYPE;
+extern map SHIFTS;
 
 #endif
@@ -0,0 +1,173 @@
+#include "object.h"
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+objectFile constructObjectFile(arena *pool) {
+  objectFile o = {constructArray(), constructArray(), NULL, 0, 0,
+                  NULL, 0, 0, pool};
+  return o;
+}
+
+void clearObjectFile(objectFile *o) {
+  clearArray(&o->code);
+  clearArray(&o->literals);
+  free(o->symbols);
+  free(o->relocations);
+  *o = constructObjectFile(o->pool);
+}
+
+static void *grow(void *items, int *capacity, size_t itemSize) {
+  *capacity = *capacity ? 2 * *capacity : 64;
+  items = realloc(items, *capacity * itemSize);
+  if (!items) {
+    perror("realloc");
+    exit(EXIT_FAILURE);
+  }
+
+  return items;
+}
+
+int addSymbol(objectFile *o, const char *name, int length, uint32_t value,
+              bool defined) {
+  if (o->symbolCount == o->symbolCapacity) {
+    o->symbols = grow(o->symbols, &o->symbolCapacity, sizeof(symbol));
+  }
+
+  symbol *new  = &o->symbols[o->symbolCount];
+  new->name    = arenaCopy(o->pool, name, length);
+  new->value   = value;
+  new->defined = defined;
+  return o->symbolCount++;
+}
+
+void addRelocation(objectFile *o, relocationEnum kind, uint32_t instruction,
+                   uint32_t target) {
+  if (o->relocationCount == o->relocationCapacity) {
+    o->relocations = grow(o->relocations, &o->relocationCapacity,
+                          sizeof(relocation));
+  }
+
+  relocation *new  = &o->relocations[o->relocationCount++];
+  new->kind        = kind;
+  new->instruction = instruction;
+  new->target      = target;
+}
+
+static bool writeWords(FILE *file, const uint32_t *words, size_t n) {
+  return fwrite(words, sizeof(uint32_t), n, file) == n;
+}
+
+static bool readWords(FILE *file, uint32_t *words, size_t n) {
+  return fread(words, sizeof(uint32_t), n, file) == n;
+}
+
+bool writeObjectFile(const char *path, const objectFile *o) {
+  FILE *file = fopen(path, "wb");
+  uint32_t header[] = {OBJECT_MAGIC, OBJECT_VERSION, o->code.size,
+                       o->literals.size, o->symbolCount, o->relocationCount};
+
+  if (!file) {
+    return false;
+  }
+
+  bool written = writeWords(file, header, 6) &&
+                 writeWords(file, o->code.values, o->code.size) &&
+                 writeWords(file, o->literals.values, o->literals.size);
+
+  // symbols: value, defined, length of the name and the name
+  for (int i = 0; written && i < o->symbolCount; i++) {
+    symbol *s = &o->symbols[i];
+    uint32_t fields[] = {s->value, s->defined, strlen(s->name)};
+    written = writeWords(file, fields, 3) &&
+              fwrite(s->name, 1, fields[2], file) == fields[2];
+  }
+
+  for (int i = 0; written && i < o->relocationCount; i++) {
+    relocation *r = &o->relocations[i];
+    uint32_t fields[] = {r->kind, r->instruction, r->target};
+    written = writeWords(file, fields, 3);
+  }
+
+  return !fclose(file) && written;
+}
+
+bool readObjectFile(const char *path, objectFile *o) {
+  FILE *file = fopen(path, "rb");
+  uint32_t header[6];
+
+  if (!file) {
+    return false;
+  }
+
+  bool valid = readWords(file, header, 6) && header[0] == OBJECT_MAGIC &&
+               header[1] == OBJECT_VERSION;
+
+  for (uint32_t i = 0; valid && i < header[2] + header[3]; i++) {
+    uint32_t word;
+    valid = readWords(file, &word, 1);
+    append(i < header[2] ? &o->code : &o->literals, word);
+  }
+
+  for (uint32_t i = 0; valid && i < header[4]; i++) {
+    uint32_t fields[3];
+    char name[MAX_SYMBOL_LENGTH];
+    valid = readWords(file, fields, 3) && fields[2] < MAX_SYMBOL_LENGTH &&
+            fread(name, 1, fields[2], file) == fields[2];
+    if (valid) {
+      addSymbol(o, name, fields[2], fields[0], fields[1]);
+    }
+  }
+
+  for (uint32_t i = 0; valid && i < header[5]; i++) {
+    uint32_t fields[3];
+    valid = readWords(file, fields, 3) &&
+            (fields[0] == BRANCH_RELOCATION ||
+             fields[0] == LITERAL_RELOCATION);
+    if (valid) {
+      addRelocation(o, fields[0], fields[1], fields[2]);
+    }
+  }
+
+  fclose(file);
+  return valid;
+}
+
+/* Orders symbols by value, then by name */
+static int compareSymbols(const void *a, const void *b) {
+  const symbol *x = a;
+  const symbol *y = b;
+
+  if (x->value != y->value) {
+    return x->value < y->value ? -1 : 1;
+  }
+  return strcmp(x->name, y->name);
+}
+
+bool writeSymbolFile(const char *path, map labelMapping) {
+  int count = 0;
+  for (mapNode *ptr = labelMapping.head; ptr; ptr = ptr->next) {
+    count++;
+  }
+
+  symbol *symbols = malloc((count ? count : 1) * sizeof(symbol));
+  if (!symbols) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+  count = 0;
+  for (mapNode *ptr = labelMapping.head; ptr; ptr = ptr->next) {
+    symbol s = {ptr->key, ptr->value, true};
+    symbols[count++] = s;
+  }
+  qsort(symbols, count, sizeof(symbol), compareSymbols);
+
+  FILE *file = fopen(path, "w");
+  bool written = file;
+  for (int i = 0; written && i < count; i++) {
+    written = fprintf(file, "%08x %s\n",
+                      (uint32_t) (symbols[i].value * sizeof(uint32_t)),
+                      symbols[i].name) > 0;
+  }
+
+  free(symbols);
+  return file && !fclose(file) && written;
+}
@@ -0,0 +1,98 @@
+#ifndef OBJECT_H
+#define OBJECT_H
+
+#include "adts.h"
+
+// ---------------------------MACROS-----------------------------
+#define OBJECT_MAGIC 0x4F4D5241
+#define OBJECT_VERSION 1
+#define MAX_SYMBOL_LENGTH 512
+#define SYMBOL_SUFFIX ".sym"
+
+// -------------------------TYPES---------------------------------
+typedef struct symbol symbol;
+typedef struct relocation relocation;
+typedef struct objectFile objectFile;
+
+// --------------------------ENUMS-------------------------------
+typedef enum {BRANCH_RELOCATION, LITERAL_RELOCATION} relocationEnum;
+
+// -------------------------STRUCTS-------------------------------
+/**
+* A label of a module: value is the index of the instruction it labels if
+* the module defines and exports it (with .global), otherwise the module only
+* uses it. The labels a module doesn't export are not symbols
+**/
+struct symbol {
+  char     *name;
+  uint32_t value;
+  bool     defined;
+};
+
+/**
+* An instruction of the code whose offset is only known once the modules
+* are placed in the image:
+* BRANCH_RELOCATION   a branch to the symbol of index target
+* LITERAL_RELOCATION  a ldr from the slot target of the module's literal pool
+**/
+struct relocation {
+  relocationEnum kind;
+  uint32_t       instruction;
+  uint32_t       target;
+};
+
+/**
+* A relocatable module: its instructions (with the pools placed by .ltorg),
+* its last literal pool, the labels it exports or uses and the instructions
+* to relocate. The linker places every module followed by its last pool, so
+* the image is the one the modules would assemble to as a single file with
+* a .ltorg at the end of each of them.
+* The symbol names are allocated from pool
+**/
+struct objectFile {
+  array      code;
+  array      literals;
+  symbol     *symbols;
+  int        symbolCount;
+  int        symbolCapacity;
+  relocation *relocations;
+  int        relocationCount;
+  int        relocationCapacity;
+  arena      *pool;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+/* Constructor function that will return an empty object using pool */
+objectFile constructObjectFile(arena *pool);
+
+/* Frees the object (the symbol names are owned by the pool) */
+void clearObjectFile(objectFile *o);
+
+/* Adds the symbol of the length characters of name and returns its index */
+int addSymbol(objectFile *o, const char *name, int length, uint32_t value,
+              bool defined);
+
+/* Adds a relocation of kind for instruction */
+void addRelocation(objectFile *o, relocationEnum kind, uint32_t instruction,
+                   uint32_t target);
+
+/**
+* Writes the object to path
+* Returns false if the file couldn't be written
+**/
+bool writeObjectFile(const char *path, const objectFile *o);
+
+/**
+* Reads the object saved at path into the empty object o
+* Returns false if there is no valid object at path
+**/
+bool readObjectFile(const char *path, objectFile *o);
+
+/**
+* Writes the labels of labelMapping to path for the emulator: a line
+* "<byte address in hex> <label>" for every label, in address order
+* Returns false if the file couldn't be written
+**/
+bool writeSymbolFile(const char *path, map labelMapping);
+
+#endif
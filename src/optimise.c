@@ -0,0 +1,509 @@
+#include "optimise.h"
+#include "schedule.h"
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+// ------------------------INSTRUCTIONS---------------------------
+uint32_t conditionOf(uint32_t word) {
+  return word >> CONDITION_SHIFT;
+}
+
+bool isBranch(uint32_t word) {
+  return ((word >> 25) & 0x7) == 0x5;
+}
+
+uint32_t branchTarget(uint32_t word, uint32_t address) {
+  // the offset is a signed number of words from the pc
+  int32_t offset = (int32_t) ((word & BRANCH_OFFSET_MASK) << 8) >> 8;
+  return address + PC_OFFSET + offset;
+}
+
+bool isMultiply(uint32_t word) {
+  return ((word >> 22) & 0x3F) == 0 && ((word >> 4) & 0xF) == 0x9;
+}
+
+bool isDataProcessing(uint32_t word) {
+  return ((word >> 26) & 0x3) == 0 && !isMultiply(word);
+}
+
+bool isPcRelative(uint32_t word) {
+  return ((word >> 26) & 0x3) == 1 && ((word >> 16) & 0xF) == PC_REGISTER &&
+         !(word & IMMEDIATE_BIT) && (word & PRE_INDEX_BIT) &&
+         !(word & WRITE_BACK_BIT);
+}
+
+bool setsFlags(uint32_t word) {
+  return ((word >> 26) & 0x3) == 0 && (word & SET_FLAGS_BIT);
+}
+
+static uint32_t opcodeOf(uint32_t word) {
+  return (word >> 21) & 0xF;
+}
+
+static uint32_t rn(uint32_t word) {
+  return (word >> 16) & 0xF;
+}
+
+static uint32_t rd(uint32_t word) {
+  return (word >> 12) & 0xF;
+}
+
+int64_t transferAddress(uint32_t word, uint32_t address) {
+  int64_t offset = word & TRANSFER_OFFSET_MASK;
+  return (int64_t) (address + PC_OFFSET) * MEMORY_SIZE +
+         (word & UP_BIT ? offset : -offset);
+}
+
+// -------------------------REDUNDANCY----------------------------
+/* Returns true iff the instruction doesn't change anything */
+static bool isNoOperation(uint32_t word) {
+  if (!isDataProcessing(word) || (word & SET_FLAGS_BIT) ||
+      rd(word) == PC_REGISTER) {
+    return false;
+  }
+
+  switch (opcodeOf(word)) {
+    case MOV_OPCODE:
+      // mov rX, rX without a shift
+      return !(word & IMMEDIATE_BIT) && (word & 0xFFF) == rd(word);
+    case ORR_OPCODE:
+    case ADD_OPCODE:
+    case SUB_OPCODE:
+    case EOR_OPCODE:
+      // op rX, rX, #0 whatever the rotation
+      return (word & IMMEDIATE_BIT) && (word & 0xFF) == 0 &&
+             rn(word) == rd(word);
+    default:
+      return false;
+  }
+}
+
+/**
+* Returns true iff the flags set before the instruction at from are only
+* tested for Z (eq, ne) until they are set again, on every path followed
+* within budget instructions
+**/
+static bool onlyZeroTested(const program *prog, uint32_t from, int branches,
+                           int *budget) {
+  for (uint32_t i = from; i < prog->size && !prog->data[i]; i++) {
+    uint32_t word = prog->words[i];
+    uint32_t condition = conditionOf(word);
+
+    if (--*budget < 0) {
+      return false;
+    }
+    if (word == 0) {
+      // halt
+      return true;
+    }
+    if (condition != AL_CONDITION && condition != EQ_CONDITION &&
+        condition != NE_CONDITION) {
+      return false;
+    }
+    if (isBranch(word)) {
+      if (!branches || !onlyZeroTested(prog, branchTarget(word, i),
+                                       branches - 1, budget)) {
+        return false;
+      }
+      if (condition == AL_CONDITION) {
+        return true;
+      }
+    } else if (setsFlags(word)) {
+      return true;
+    }
+  }
+
+  // running into a pool
+  return false;
+}
+
+/* Returns true iff the pc relative ldr at address loads a literal */
+static bool loadsLiteral(const program *prog, uint32_t word, uint32_t address,
+                         uint32_t *value) {
+  int64_t target = transferAddress(word, address);
+
+  if (!isPcRelative(word) || !(word & LOAD_BIT) || (word & BYTE_BIT) ||
+      target < 0 || target % MEMORY_SIZE ||
+      target / MEMORY_SIZE >= prog->size ||
+      !prog->data[target / MEMORY_SIZE]) {
+    return false;
+  }
+
+  *value = prog->words[target / MEMORY_SIZE];
+  return true;
+}
+
+/**
+* Returns true iff the instruction at i can go because of the instruction
+* at previous, which is executed right before it
+**/
+static bool isRedundantAfter(const program *prog, uint32_t previous,
+                             uint32_t i) {
+  uint32_t first = prog->words[previous];
+  uint32_t second = prog->words[i];
+  uint32_t a, b;
+
+  if (conditionOf(first) != AL_CONDITION ||
+      conditionOf(second) != AL_CONDITION || rd(first) == PC_REGISTER) {
+    return false;
+  }
+
+  if (isDataProcessing(first) && isDataProcessing(second) &&
+      opcodeOf(first) == SUB_OPCODE && (first & SET_FLAGS_BIT) &&
+      opcodeOf(second) == CMP_OPCODE && (second & IMMEDIATE_BIT) &&
+      (second & 0xFF) == 0 && rn(second) == rd(first)) {
+    // subs rX sets Z and N as cmp rX, #0 does, but not C and V
+    int budget = MAX_FLAG_SCAN;
+    return onlyZeroTested(prog, i + 1, MAX_FLAG_BRANCHES, &budget);
+  }
+
+  if (isDataProcessing(first) && !(first & SET_FLAGS_BIT) &&
+      (first & IMMEDIATE_BIT) && opcodeOf(first) == MOV_OPCODE) {
+    // mov rX, #c twice
+    return first == second;
+  }
+
+  return loadsLiteral(prog, first, previous, &a) &&
+         loadsLiteral(prog, second, i, &b) && rd(first) == rd(second) &&
+         a == b;
+}
+
+// ------------------------CONTROL FLOW---------------------------
+/* Returns true iff the inverse of the condition can be encoded */
+static bool isInvertible(uint32_t condition) {
+  return condition == EQ_CONDITION || condition == NE_CONDITION ||
+         (condition >= GE_CONDITION && condition <= LE_CONDITION);
+}
+
+bool writesPc(uint32_t word) {
+  uint32_t opcode = opcodeOf(word);
+
+  if (isDataProcessing(word)) {
+    // tst, teq, cmp and cmn only set the flags
+    return rd(word) == PC_REGISTER && (opcode < 0x8 || opcode > 0xB);
+  }
+  if (((word >> 26) & 0x3) == 1) {
+    return (word & LOAD_BIT) && rd(word) == PC_REGISTER;
+  }
+  return isMultiply(word) && rn(word) == PC_REGISTER;
+}
+
+/* Returns true iff the word at address is a b which is always taken */
+static bool isJump(const program *prog, uint32_t address) {
+  return address < prog->size && !prog->data[address] &&
+         isBranch(prog->words[address]) &&
+         conditionOf(prog->words[address]) == AL_CONDITION &&
+         !(prog->words[address] & LINK_BIT);
+}
+
+/**
+* Retargets every branch to a b at the destination of the b, following
+* chains of at most MAX_BRANCH_CHAIN branches (loops of b never end)
+**/
+static void threadBranches(program *prog) {
+  for (uint32_t i = 0; i < prog->size; i++) {
+    if (prog->data[i] || !isBranch(prog->words[i])) {
+      continue;
+    }
+
+    uint32_t target = branchTarget(prog->words[i], i);
+    for (int hops = 0; hops < MAX_BRANCH_CHAIN && isJump(prog, target);
+         hops++) {
+      target = branchTarget(prog->words[target], target);
+    }
+    prog->words[i] = (prog->words[i] & ~BRANCH_OFFSET_MASK) |
+                     branchOffset(i, target);
+  }
+}
+
+/**
+* Marks in removed every instruction which can't be reached from the first
+* one. Nothing is marked if the pc is written by anything but a branch
+* since the destination isn't known
+**/
+static void markUnreachable(const program *prog, bool *removed) {
+  bool *reached = calloc(prog->size + 1, sizeof(bool));
+  uint32_t *stack = malloc((prog->size + 1) * sizeof(uint32_t));
+  if (!reached || !stack) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+  int top = 0;
+
+  for (uint32_t i = 0; i < prog->size; i++) {
+    if (!prog->data[i] && writesPc(prog->words[i])) {
+      free(reached);
+      free(stack);
+      return;
+    }
+  }
+
+  if (prog->size) {
+    reached[0] = true;
+    stack[top++] = 0;
+  }
+
+  while (top) {
+    uint32_t i = stack[--top];
+    uint32_t word = prog->words[i];
+    uint32_t next[2];
+    int n = 0;
+
+    if (word == 0) {
+      // halt
+      continue;
+    }
+    if (isBranch(word)) {
+      next[n++] = branchTarget(word, i);
+    }
+    if (!isJump(prog, i)) {
+      next[n++] = i + 1;
+    }
+
+    for (int j = 0; j < n; j++) {
+      // execution never continues into a pool
+      if (next[j] < prog->size && !prog->data[next[j]] && !reached[next[j]]) {
+        reached[next[j]] = true;
+        stack[top++] = next[j];
+      }
+    }
+  }
+
+  for (uint32_t i = 0; i < prog->size; i++) {
+    removed[i] = !prog->data[i] && !reached[i];
+  }
+
+  free(reached);
+  free(stack);
+}
+
+bool *jumpTargets(const program *prog, const map *labelMapping) {
+  bool *targets = calloc(prog->size + 1, sizeof(bool));
+  if (!targets) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+
+  for (mapNode *ptr = labelMapping->head; ptr; ptr = ptr->next) {
+    if (ptr->value <= prog->size) {
+      targets[ptr->value] = true;
+    }
+  }
+  for (uint32_t i = 0; i < prog->size; i++) {
+    uint32_t target = branchTarget(prog->words[i], i);
+    if (!prog->data[i] && isBranch(prog->words[i]) && target <= prog->size) {
+      targets[target] = true;
+    }
+  }
+
+  return targets;
+}
+
+/**
+* Marks in removed every instruction which is redundant given the one
+* before it, or on its own
+**/
+static void markRedundant(const program *prog, const map *labelMapping,
+                          bool *removed) {
+  // an instruction which can be jumped to is not always run after the one
+  // before it
+  bool *targets = jumpTargets(prog, labelMapping);
+
+  // previous is the last instruction kept, entered is set if anything
+  // after it can be jumped to
+  uint32_t previous = 0;
+  bool entered = true;
+  for (uint32_t i = 0; i < prog->size; i++) {
+    entered |= targets[i];
+    removed[i] = false;
+    if (prog->data[i]) {
+      entered = true;
+    } else if (isNoOperation(prog->words[i]) ||
+               (!entered && isRedundantAfter(prog, previous, i))) {
+      removed[i] = true;
+    } else {
+      previous = i;
+      entered = false;
+    }
+  }
+
+  free(targets);
+}
+
+/**
+* Returns true iff the instruction at i can run under a condition instead of
+* being branched over. Only the last one of a block may set the flags which
+* the others test
+**/
+static bool isPredicable(const program *prog, uint32_t i, bool last) {
+  uint32_t word = prog->words[i];
+
+  return i < prog->size && !prog->data[i] && word &&
+         conditionOf(word) == AL_CONDITION && !isBranch(word) &&
+         !writesPc(word) && (last || !setsFlags(word));
+}
+
+/**
+* Rewrites every bCC skip over 1 to MAX_PREDICATED instructions into the
+* same instructions predicated on the inverse condition and marks the branch
+* in removed. Nothing may jump into the block
+**/
+static void predicateBlocks(program *prog, const map *labelMapping,
+                            bool *removed) {
+  bool *targets = jumpTargets(prog, labelMapping);
+
+  for (uint32_t i = 0; i < prog->size; i++) {
+    removed[i] = false;
+  }
+
+  for (uint32_t i = 0; i < prog->size; i++) {
+    uint32_t word = prog->words[i];
+    uint32_t condition = conditionOf(word);
+    uint32_t skip = branchTarget(word, i);
+    uint32_t n = skip - i - 1;
+
+    if (prog->data[i] || !isBranch(word) || (word & LINK_BIT) ||
+        !isInvertible(condition) || skip <= i + 1 ||
+        n > MAX_PREDICATED) {
+      continue;
+    }
+
+    bool predicable = true;
+    for (uint32_t j = i + 1; j < skip && predicable; j++) {
+      predicable = !targets[j] && isPredicable(prog, j, j == skip - 1);
+    }
+    if (!predicable) {
+      continue;
+    }
+
+    // the pairs of conditions only differ in their lowest bit
+    for (uint32_t j = i + 1; j < skip; j++) {
+      prog->words[j] = (prog->words[j] & ~(0xFu << CONDITION_SHIFT)) |
+                       (condition ^ 1) << CONDITION_SHIFT;
+    }
+    removed[i] = true;
+    i = skip - 1;
+  }
+
+  free(targets);
+}
+
+/* Marks in removed every branch to the instruction right after it */
+static void markFallThroughs(const program *prog, bool *removed) {
+  for (uint32_t i = 0; i < prog->size; i++) {
+    removed[i] = !prog->data[i] && isBranch(prog->words[i]) &&
+                 !(prog->words[i] & LINK_BIT) &&
+                 branchTarget(prog->words[i], i) == i + 1;
+  }
+}
+
+// -------------------------OPTIMISER-----------------------------
+uint32_t optimiseProgram(uint32_t *words, uint32_t size, literalPools *pools,
+                         map *labelMapping) {
+  bool *data = calloc(size + 1, sizeof(bool));
+  bool *removed = calloc(size + 1, sizeof(bool));
+  if (!data || !removed) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  program prog = {words, size, data};
+
+  for (int p = 0; p < pools->size; p++) {
+    literalPool *pool = &pools->pools[p];
+    for (uint32_t i = 0; pool->start != UNPLACED_POOL && i < poolSize(pool);
+         i++) {
+      data[pool->start + i] = true;
+    }
+  }
+
+  // branch to the end of a chain of branches, then drop what can't be run
+  // anymore, the instructions which change nothing, the branches left
+  // pointing to the next instruction and at last the short forward branches
+  // replaced by conditional instructions
+  threadBranches(&prog);
+  markUnreachable(&prog, removed);
+  removeInstructions(&prog, removed, pools, labelMapping);
+  markRedundant(&prog, labelMapping, removed);
+  removeInstructions(&prog, removed, pools, labelMapping);
+  markFallThroughs(&prog, removed);
+  removeInstructions(&prog, removed, pools, labelMapping);
+  predicateBlocks(&prog, labelMapping, removed);
+  removeInstructions(&prog, removed, pools, labelMapping);
+  scheduleProgram(&prog, labelMapping);
+
+  free(data);
+  free(removed);
+  return prog.size;
+}
+
+/* Returns the new address of the word at address, in words */
+static int64_t relocated(const uint32_t *newIndex, uint32_t size,
+                         int64_t address) {
+  if (address < 0) {
+    return address;
+  }
+  if (address > size) {
+    return address - size + newIndex[size];
+  }
+  return newIndex[address];
+}
+
+void removeInstructions(program *prog, const bool *removed,
+                        literalPools *pools, map *labelMapping) {
+  uint32_t *newIndex = malloc((prog->size + 1) * sizeof(uint32_t));
+  if (!newIndex) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+
+  newIndex[0] = 0;
+  for (uint32_t i = 0; i < prog->size; i++) {
+    newIndex[i + 1] = newIndex[i] + !removed[i];
+  }
+
+  for (uint32_t i = 0; i < prog->size; i++) {
+    uint32_t word = prog->words[i];
+    if (removed[i] || prog->data[i]) {
+      continue;
+    }
+
+    if (isBranch(word)) {
+      int64_t target = relocated(newIndex, prog->size,
+                                 (int32_t) branchTarget(word, i));
+      prog->words[i] = (word & ~BRANCH_OFFSET_MASK) |
+                       branchOffset(newIndex[i], target);
+    } else if (isPcRelative(word)) {
+      // the accessed word moves, the byte within it doesn't
+      int64_t address = transferAddress(word, i);
+      int64_t target = relocated(newIndex, prog->size,
+                                 address / MEMORY_SIZE) * MEMORY_SIZE +
+                       address % MEMORY_SIZE;
+      int64_t offset = target - (int64_t) (newIndex[i] + PC_OFFSET) *
+                                MEMORY_SIZE;
+      // nothing gets further away so the offset still fits
+      assert(offset <= TRANSFER_OFFSET_MASK && -offset <= TRANSFER_OFFSET_MASK);
+      word &= ~(UP_BIT | TRANSFER_OFFSET_MASK);
+      prog->words[i] = word | (offset >= 0 ? UP_BIT | offset : -offset);
+    }
+  }
+
+  uint32_t size = 0;
+  for (uint32_t i = 0; i < prog->size; i++) {
+    if (!removed[i]) {
+      prog->words[size] = prog->words[i];
+      prog->data[size++] = prog->data[i];
+    }
+  }
+
+  for (int p = 0; p < pools->size; p++) {
+    if (pools->pools[p].start != UNPLACED_POOL) {
+      pools->pools[p].start = relocated(newIndex, prog->size,
+                                        pools->pools[p].start);
+    }
+  }
+  for (mapNode *ptr = labelMapping->head; ptr; ptr = ptr->next) {
+    ptr->value = relocated(newIndex, prog->size, ptr->value);
+  }
+
+  prog->size = size;
+  free(newIndex);
+}
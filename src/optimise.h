@@ -0,0 +1,122 @@
+#ifndef OPTIMISE_H
+#define OPTIMISE_H
+
+#include "fixup.h"
+#include "literals.h"
+
+// ---------------------------MACROS-----------------------------
+#define CONDITION_SHIFT 28
+#define EQ_CONDITION 0x0
+#define NE_CONDITION 0x1
+#define GE_CONDITION 0xA
+#define LE_CONDITION 0xD
+#define AL_CONDITION 0xE
+#define PC_REGISTER 15
+#define SET_FLAGS_BIT (1 << 20)
+#define IMMEDIATE_BIT (1 << 25)
+#define PRE_INDEX_BIT (1 << 24)
+#define BYTE_BIT (1 << 22)
+#define WRITE_BACK_BIT (1 << 21)
+#define LOAD_BIT (1 << 20)
+#define LINK_BIT (1 << 24)
+#define MOV_OPCODE 0xD
+#define ORR_OPCODE 0xC
+#define ADD_OPCODE 0x4
+#define SUB_OPCODE 0x2
+#define EOR_OPCODE 0x1
+#define TST_OPCODE 0x8
+#define CMP_OPCODE 0xA
+#define CMN_OPCODE 0xB
+#define ADC_OPCODE 0x5
+#define RSC_OPCODE 0x7
+#define MVN_OPCODE 0xF
+#define ACCUMULATE_BIT (1 << 21)
+#define SHIFT_BY_REGISTER_BIT (1 << 4)
+// how far the flags of a cmp are followed to check that only Z and N are
+// tested, in instructions and in branches taken
+#define MAX_FLAG_SCAN 64
+#define MAX_FLAG_BRANCHES 4
+// longest chain of b followed to find where a branch ends up
+#define MAX_BRANCH_CHAIN 16
+// longest block a conditional branch skips which is predicated instead
+#define MAX_PREDICATED 3
+
+// -------------------------TYPES---------------------------------
+typedef struct program program;
+
+// -------------------------STRUCTS-------------------------------
+/**
+* An assembled program kept in memory: size words of which the ones marked
+* in data are literals, not instructions
+**/
+struct program {
+  uint32_t *words;
+  uint32_t size;
+  bool     *data;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+/**
+* Optimises the size words (-O): every branch to a b goes straight to the
+* end of the chain, the instructions which can't be reached and the
+* branches to the next instruction are removed, a bCC over at most
+* MAX_PREDICATED instructions becomes the instructions predicated on the
+* inverse condition, and the redundant instructions are removed:
+* mov rX, rX                       without a shift
+* add/sub/orr/eor rX, rX, #0       which don't set the flags
+* cmp rX, #0                       right after a sub which sets the flags of
+*                                  rX, if only Z and N are tested afterwards
+* a literal load or mov #          loading the same constant in the same
+*                                  register as the instruction before it
+* Then the instructions of every basic block are scheduled (see
+* scheduleProgram)
+* The words are moved down in place, the branches, the loads from the pools,
+* the pools and labelMapping are updated to the new addresses
+* Returns the new number of words
+**/
+uint32_t optimiseProgram(uint32_t *words, uint32_t size, literalPools *pools,
+                         map *labelMapping);
+
+/**
+* Deletes the instructions marked in removed from prog and relocates the
+* branches and pc relative loads which cross them, the pools and the labels
+* A label of a removed instruction moves to the next one
+**/
+void removeInstructions(program *prog, const bool *removed,
+                        literalPools *pools, map *labelMapping);
+
+// ------------------------INSTRUCTIONS---------------------------
+/* Returns the condition of the instruction */
+uint32_t conditionOf(uint32_t word);
+
+/* Returns true iff the word is a branch */
+bool isBranch(uint32_t word);
+
+/* Returns the word the branch at address jumps to */
+uint32_t branchTarget(uint32_t word, uint32_t address);
+
+/* Returns true iff the word is a multiply */
+bool isMultiply(uint32_t word);
+
+/* Returns true iff the word is a data processing instruction */
+bool isDataProcessing(uint32_t word);
+
+/* Returns true iff the word is a ldr/str with an offset from the pc */
+bool isPcRelative(uint32_t word);
+
+/* Returns the byte address the pc relative ldr/str at address accesses */
+int64_t transferAddress(uint32_t word, uint32_t address);
+
+/* Returns true iff the instruction sets the flags */
+bool setsFlags(uint32_t word);
+
+/* Returns true iff the instruction writes the pc other than as a branch */
+bool writesPc(uint32_t word);
+
+/**
+* Returns an array (to be freed) marking every word of prog which can be
+* jumped to: the labels and the targets of the branches
+**/
+bool *jumpTargets(const program *prog, const map *labelMapping);
+
+#endif
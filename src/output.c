@@ -0,0 +1,107 @@
+#include "output.h"
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+outputWriter constructOutputWriter(const char *path, uint32_t capacity) {
+  outputWriter w = {path, NULL, NULL, 0, 0, 0, capacity};
+  return w;
+}
+
+uint32_t wordCount(const outputWriter *w) {
+  return w->base + w->size;
+}
+
+bool isWindowFull(const outputWriter *w) {
+  return w->capacity != KEEP_ALL_WORDS && w->size >= w->capacity;
+}
+
+void emitWord(outputWriter *w, uint32_t word) {
+  if (w->size == w->allocated) {
+    w->allocated = w->allocated ? 2 * w->allocated : OUTPUT_CHUNK_WORDS;
+    uint32_t *window = realloc(w->window, w->allocated * sizeof(uint32_t));
+    if (!window) {
+      perror("realloc");
+      exit(EXIT_FAILURE);
+    }
+    w->window = window;
+  }
+
+  w->window[w->size++] = word;
+}
+
+uint32_t *wordAt(outputWriter *w, uint32_t index) {
+  assert(index >= w->base && index < wordCount(w));
+  return &w->window[index - w->base];
+}
+
+static bool openOutput(outputWriter *w) {
+  if (!w->file) {
+    // read back is needed to patch words which are already written
+    w->file = fopen(w->path, "w+b");
+  }
+
+  return w->file;
+}
+
+void patchWord(outputWriter *w, uint32_t index, uint32_t mask, uint32_t bits) {
+  if (index >= w->base) {
+    uint32_t *word = wordAt(w, index);
+    *word = (*word & ~mask) | (bits & mask);
+    return;
+  }
+
+  // the word has been flushed already
+  uint32_t word = 0;
+  fseek(w->file, (long) index * sizeof(uint32_t), SEEK_SET);
+  if (fread(&word, sizeof(uint32_t), 1, w->file) != 1) {
+    perror("fread");
+    exit(EXIT_FAILURE);
+  }
+  word = (word & ~mask) | (bits & mask);
+  fseek(w->file, (long) index * sizeof(uint32_t), SEEK_SET);
+  fwrite(&word, sizeof(uint32_t), 1, w->file);
+  fseek(w->file, 0, SEEK_END);
+}
+
+void flushWords(outputWriter *w, uint32_t end) {
+  if (end <= w->base) {
+    return;
+  }
+  if (end > wordCount(w)) {
+    end = wordCount(w);
+  }
+
+  uint32_t n = end - w->base;
+  if (!openOutput(w)) {
+    perror(w->path);
+    exit(EXIT_FAILURE);
+  }
+  fwrite(w->window, sizeof(uint32_t), n, w->file);
+  memmove(w->window, w->window + n, (w->size - n) * sizeof(uint32_t));
+  w->size -= n;
+  w->base = end;
+}
+
+bool closeOutputWriter(outputWriter *w) {
+  bool ok = openOutput(w);
+
+  if (ok) {
+    flushWords(w, wordCount(w));
+    ok = !ferror(w->file);
+    ok &= !fclose(w->file);
+  }
+  w->file = NULL;
+  free(w->window);
+  w->window = NULL;
+
+  return ok;
+}
+
+void discardOutputWriter(outputWriter *w) {
+  if (w->file) {
+    fclose(w->file);
+    remove(w->path);
+  }
+  w->file = NULL;
+  free(w->window);
+  w->window = NULL;
+}
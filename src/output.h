@@ -0,0 +1,65 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include "headers.h"
+
+// ---------------------------MACROS-----------------------------
+#define OUTPUT_CHUNK_WORDS 4096
+#define KEEP_ALL_WORDS 0
+
+// -------------------------TYPES---------------------------------
+typedef struct outputWriter outputWriter;
+
+// -------------------------STRUCTS-------------------------------
+/**
+* Writes the assembled words to the output file in chunks. window holds the
+* words from index base onwards which haven't been written yet. capacity is
+* the number of words kept in memory before they have to be flushed, or
+* KEEP_ALL_WORDS to keep the whole program in memory until the end.
+* The file is only created by the first flush
+**/
+struct outputWriter {
+  const char *path;
+  FILE       *file;
+  uint32_t   *window;
+  uint32_t   base;
+  uint32_t   size;
+  uint32_t   allocated;
+  uint32_t   capacity;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+/* Constructor function that will return a writer for the file at path */
+outputWriter constructOutputWriter(const char *path, uint32_t capacity);
+
+/* Returns the number of words emitted so far (flushed or not) */
+uint32_t wordCount(const outputWriter *w);
+
+/* Returns true iff the window has to be flushed before the next word */
+bool isWindowFull(const outputWriter *w);
+
+/* Appends word to the program */
+void emitWord(outputWriter *w, uint32_t word);
+
+/* Returns the word at index which must not be flushed yet */
+uint32_t *wordAt(outputWriter *w, uint32_t index);
+
+/**
+* Replaces the bits of mask in the word at index with bits. If the word has
+* already been flushed it is patched in place in the file
+**/
+void patchWord(outputWriter *w, uint32_t index, uint32_t mask, uint32_t bits);
+
+/* Writes all the words before index end to the file */
+void flushWords(outputWriter *w, uint32_t end);
+
+/**
+* Flushes every word and closes the file
+* Returns false if the file couldn't be written
+**/
+bool closeOutputWriter(outputWriter *w);
+
+/* Frees the writer and removes the file if it has been created */
+void discardOutputWriter(outputWriter *w);
+
+#endif
@@ -0,0 +1,137 @@
+#include "predictor.h"
+
+static const char *PREDICTOR_NAMES[] = {"static", "bimodal", "btac"};
+
+bool parsePredictor(const char *name, predictor_kind_t *kind) {
+  for (int i = PREDICT_STATIC; i <= PREDICT_BTAC; i++) {
+    if (!strcmp(name, PREDICTOR_NAMES[i])) {
+      *kind = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+predictor_t *createPredictor(predictor_kind_t kind) {
+  predictor_t *predictor = calloc(1, sizeof(predictor_t));
+  if (!predictor) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  predictor->kind = kind;
+  //weakly not taken
+  memset(predictor->counters, COUNTER_TAKEN - 1, BIMODAL_ENTRIES);
+  return predictor;
+}
+
+//--------------Prediction-----------------------------------------------------
+/* Moves the 2 bit counter towards the outcome */
+static void train(uint8_t *counter, bool taken) {
+  if (taken && *counter < COUNTER_MAX) {
+    (*counter)++;
+  } else if (!taken && *counter > 0) {
+    (*counter)--;
+  }
+}
+
+/* Backward taken, forward not taken, unconditional branches always taken */
+static bool predictStatic(int instruction) {
+  return ((uint32_t) instruction >> 28) == 0xE ||
+         (instruction & BRANCH_OFFSET_SIGN);
+}
+
+static bool predictBtac(predictor_t *predictor, int address, int instruction,
+                        bool taken) {
+  int index = (address / 4) % BTAC_ENTRIES;
+  uint32_t tag = address / 4 / BTAC_ENTRIES;
+  bool hit = predictor->btacValid[index] && predictor->btacTags[index] == tag;
+  bool prediction = hit ? predictor->btacCounters[index] >= COUNTER_TAKEN
+                        : predictStatic(instruction);
+
+  if (hit) {
+    train(&predictor->btacCounters[index], taken);
+  } else if (taken) {
+    //only the taken branches are allocated, weakly taken
+    predictor->btacValid[index] = true;
+    predictor->btacTags[index] = tag;
+    predictor->btacCounters[index] = COUNTER_TAKEN;
+  }
+  return prediction;
+}
+
+bool predictBranch(predictor_t *predictor, int address, int instruction,
+                   bool taken) {
+  bool prediction;
+  switch (predictor->kind) {
+    case PREDICT_STATIC:
+      prediction = predictStatic(instruction);
+      break;
+    case PREDICT_BIMODAL: {
+      uint8_t *counter = &predictor->counters[(address / 4) % BIMODAL_ENTRIES];
+      prediction = *counter >= COUNTER_TAKEN;
+      train(counter, taken);
+      break;
+    }
+    default:
+      prediction = predictBtac(predictor, address, instruction, taken);
+  }
+
+  bool mispredicted = prediction != taken;
+  predictor->resolved++;
+  predictor->mispredicted += mispredicted;
+  if (address >= 0 && address / 4 < MEM_SIZE_WORDS) {
+    predictor->branchResolved[address / 4]++;
+    predictor->branchTaken[address / 4] += taken;
+    predictor->branchMispredicted[address / 4] += mispredicted;
+  }
+  return mispredicted;
+}
+
+//--------------Report---------------------------------------------------------
+static int compareMispredictions(const void *a, const void *b) {
+  const branch_counts_t *x = a;
+  const branch_counts_t *y = b;
+  if (x->mispredicted != y->mispredicted) {
+    return x->mispredicted > y->mispredicted ? -1 : 1;
+  }
+  return x->address < y->address ? -1 : x->address > y->address;
+}
+
+static double rate(uint64_t count, uint64_t total) {
+  return total ? 100.0 * count / total : 0.0;
+}
+
+void printPredictor(predictor_t *predictor, profile_t *symbols, FILE *out) {
+  branch_counts_t *branches = malloc(MEM_SIZE_WORDS *
+                                     sizeof(branch_counts_t));
+  if (!branches) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+  int count = 0;
+  for (int i = 0; i < MEM_SIZE_WORDS; i++) {
+    if (predictor->branchResolved[i]) {
+      branch_counts_t branch = {i * 4, predictor->branchResolved[i],
+                                predictor->branchTaken[i],
+                                predictor->branchMispredicted[i]};
+      branches[count++] = branch;
+    }
+  }
+  qsort(branches, count, sizeof(branch_counts_t), compareMispredictions);
+
+  fprintf(out, "Branch predictor %s: %" PRIu64 " branches, %" PRIu64
+          " mispredicted, %.2f%%\n", PREDICTOR_NAMES[predictor->kind],
+          predictor->resolved, predictor->mispredicted,
+          rate(predictor->mispredicted, predictor->resolved));
+  fprintf(out, "%-10s %12s %7s %12s %7s  %s\n", "Branch", "Resolved",
+          "Taken", "Mispredicted", "%", "Location");
+  for (int i = 0; i < count && i < PREDICTOR_TOP_BRANCHES; i++) {
+    fprintf(out, "0x%.8x %12" PRIu64 " %6.2f%% %12" PRIu64 " %6.2f%%",
+            branches[i].address, branches[i].resolved,
+            rate(branches[i].taken, branches[i].resolved),
+            branches[i].mispredicted,
+            rate(branches[i].mispredicted, branches[i].resolved));
+    printLocation(symbols, branches[i].address, out);
+  }
+  free(branches);
+}
@@ -0,0 +1,68 @@
+#ifndef PREDICTOR_H
+#define PREDICTOR_H
+
+#include "profile.h"
+
+#define BIMODAL_ENTRIES 512
+#define BTAC_ENTRIES 128 // the ARM1176 branch target address cache
+#define COUNTER_MAX 3 // 2 bit saturating counters
+#define COUNTER_TAKEN 2 // a counter from here predicts taken
+#define PREDICTOR_TOP_BRANCHES 20
+#define BRANCH_OFFSET_SIGN (1 << 23)
+
+/*-------------TypeDefinitions------------------*/
+typedef struct branch_counts branch_counts_t;
+
+/*-------------Defining the predictors----------*/
+enum predictor_kind {
+  PREDICT_STATIC,
+  PREDICT_BIMODAL,
+  PREDICT_BTAC
+};
+
+typedef enum predictor_kind predictor_kind_t;
+
+struct branch_counts {
+  uint32_t address;
+  uint64_t resolved;
+  uint64_t taken;
+  uint64_t mispredicted;
+};
+
+/*static: backward branches taken and forward ones not taken (BTFN), like
+  the ARM1176 static predictor. bimodal: a table of 2 bit counters indexed
+  by the pc. btac: the ARM1176 dynamic predictor, a direct mapped cache of
+  the taken branches with a 2 bit counter each, falling back on the static
+  prediction on a miss*/
+struct predictor {
+  predictor_kind_t kind;
+  uint8_t counters[BIMODAL_ENTRIES];
+  uint32_t btacTags[BTAC_ENTRIES];
+  bool btacValid[BTAC_ENTRIES];
+  uint8_t btacCounters[BTAC_ENTRIES];
+  uint64_t resolved;
+  uint64_t mispredicted;
+  //by the word address of the branch
+  uint64_t branchResolved[MEM_SIZE_WORDS];
+  uint64_t branchTaken[MEM_SIZE_WORDS];
+  uint64_t branchMispredicted[MEM_SIZE_WORDS];
+};
+
+/*------------------Prototypes-------------------*/
+bool parsePredictor(const char *name, predictor_kind_t *kind);
+/*sets kind to the predictor called name (static, bimodal or btac), returns
+  false if there is none*/
+
+predictor_t *createPredictor(predictor_kind_t kind);
+/*returns a predictor of kind which hasn't seen any branch*/
+
+bool predictBranch(predictor_t *predictor, int address, int instruction,
+                   bool taken);
+/*predicts the branch at address, then trains the predictor with the
+  outcome given by shouldExecute. Returns true if it was mispredicted*/
+
+void printPredictor(predictor_t *predictor, profile_t *symbols, FILE *out);
+/*prints the mispredictions of the predictor and the branches mispredicted
+  the most, with their taken and misprediction rates*/
+
+#endif
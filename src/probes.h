@@ -0,0 +1,25 @@
+#ifndef PROBES_H
+#define PROBES_H
+
+// ---------------------------MACROS-----------------------------
+/**
+* USDT probes (make USDT=1, needs sys/sdt.h from systemtap-sdt-dev). A probe
+* is a nop in the code and a note in the binary which bpftrace or perf turn
+* into a breakpoint when attached, e.g.
+*   bpftrace -e 'usdt:./emulate:emulate:branch { @[arg0] = count(); }'
+* Without USDT the probes and their arguments compile to nothing
+**/
+#ifdef USDT
+#include <sys/sdt.h>
+#define PROBE0(provider, name) DTRACE_PROBE(provider, name)
+#define PROBE1(provider, name, a) DTRACE_PROBE1(provider, name, a)
+#define PROBE2(provider, name, a, b) DTRACE_PROBE2(provider, name, a, b)
+#define PROBE3(provider, name, a, b, c) DTRACE_PROBE3(provider, name, a, b, c)
+#else
+#define PROBE0(provider, name) ((void) 0)
+#define PROBE1(provider, name, a) ((void) 0)
+#define PROBE2(provider, name, a, b) ((void) 0)
+#define PROBE3(provider, name, a, b, c) ((void) 0)
+#endif
+
+#endif
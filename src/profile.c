@@ -0,0 +1,172 @@
+#include "profile.h"
+
+profile_t *createProfile(void) {
+  profile_t *profile = calloc(1, sizeof(profile_t));
+  if (!profile) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  profile->current = -1;
+  return profile;
+}
+
+void destroyProfile(profile_t *profile) {
+  for (int i = 0; i < profile->symbolCount; i++) {
+    free(profile->symbols[i].name);
+  }
+  free(profile->symbols);
+  free(profile);
+}
+
+//--------------Symbols--------------------------------------------------------
+static int compareSymbols(const void *a, const void *b) {
+  const profile_symbol_t *x = a;
+  const profile_symbol_t *y = b;
+  if (x->address != y->address) {
+    return x->address < y->address ? -1 : 1;
+  }
+  return strcmp(x->name, y->name);
+}
+
+bool loadSymbols(profile_t *profile, const char *path) {
+  FILE *file = fopen(path, "r");
+  if (!file) {
+    return false;
+  }
+
+  int capacity = 0;
+  uint32_t address;
+  char name[MAX_LABEL_LENGTH];
+  while (fscanf(file, "%" SCNx32 " %511s", &address, name) == 2) {
+    if (profile->symbolCount == capacity) {
+      capacity = capacity ? 2 * capacity : 16;
+      profile->symbols = realloc(profile->symbols,
+                                 capacity * sizeof(profile_symbol_t));
+      if (!profile->symbols) {
+        perror("realloc");
+        exit(EXIT_FAILURE);
+      }
+    }
+    profile_symbol_t *symbol = &profile->symbols[profile->symbolCount++];
+    symbol->address = address;
+    symbol->name = malloc(strlen(name) + 1);
+    if (!symbol->name) {
+      perror("malloc");
+      exit(EXIT_FAILURE);
+    }
+    strcpy(symbol->name, name);
+  }
+  fclose(file);
+
+  qsort(profile->symbols, profile->symbolCount, sizeof(profile_symbol_t),
+        compareSymbols);
+  return true;
+}
+
+int findSymbol(profile_t *profile, uint32_t address) {
+  //binary search for the first label after address
+  int low = 0;
+  int high = profile->symbolCount;
+  while (low < high) {
+    int middle = (low + high) / 2;
+    if (profile->symbols[middle].address <= address) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low ? low - 1 : NO_SYMBOL;
+}
+
+//--------------Report---------------------------------------------------------
+static int compareEntries(const void *a, const void *b) {
+  const profile_entry_t *x = a;
+  const profile_entry_t *y = b;
+  uint64_t totalX = x->executed + x->skipped;
+  uint64_t totalY = y->executed + y->skipped;
+  if (totalX != totalY) {
+    return totalX > totalY ? -1 : 1;
+  }
+  return x->address < y->address ? -1 : x->address > y->address;
+}
+
+void printLocation(profile_t *profile, uint32_t address, FILE *out) {
+  int symbol = findSymbol(profile, address);
+  if (symbol == NO_SYMBOL) {
+    fprintf(out, "\n");
+  } else if (profile->symbols[symbol].address == address) {
+    fprintf(out, "  %s\n", profile->symbols[symbol].name);
+  } else {
+    fprintf(out, "  %s+0x%x\n", profile->symbols[symbol].name,
+            address - profile->symbols[symbol].address);
+  }
+}
+
+void printProfile(profile_t *profile, FILE *out) {
+  profile_entry_t *entries = malloc(MEM_SIZE_WORDS * sizeof(profile_entry_t));
+  //the counters of every label, whose index + 1 is kept as the address, and
+  //of the code before the first label
+  profile_entry_t *routines = calloc(profile->symbolCount + 1,
+                                     sizeof(profile_entry_t));
+  if (!entries || !routines) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+
+  int count = 0;
+  profile_entry_t total = {0, 0, 0, 0};
+  for (int i = 0; i < MEM_SIZE_WORDS; i++) {
+    if (!profile->executed[i] && !profile->skipped[i]) {
+      continue;
+    }
+    profile_entry_t entry = {i * 4, profile->executed[i], profile->skipped[i],
+                             profile->accesses[i]};
+    entries[count++] = entry;
+    total.executed += entry.executed;
+    total.skipped += entry.skipped;
+    total.accesses += entry.accesses;
+
+    int label = findSymbol(profile, i * 4) + 1;
+    profile_entry_t *routine = &routines[label];
+    routine->address = label;
+    routine->executed += entry.executed;
+    routine->skipped += entry.skipped;
+    routine->accesses += entry.accesses;
+  }
+  qsort(entries, count, sizeof(profile_entry_t), compareEntries);
+
+  fprintf(out, "Profile: %" PRIu64 " executed, %" PRIu64 " skipped, %"
+          PRIu64 " memory accesses\n", total.executed, total.skipped,
+          total.accesses);
+  fprintf(out, "%-10s %12s %12s %12s  %s\n", "Address", "Executed",
+          "Skipped", "Accesses", "Location");
+  for (int i = 0; i < count && i < PROFILE_TOP_ENTRIES; i++) {
+    fprintf(out, "0x%.8x %12" PRIu64 " %12" PRIu64 " %12" PRIu64,
+            entries[i].address, entries[i].executed, entries[i].skipped,
+            entries[i].accesses);
+    printLocation(profile, entries[i].address, out);
+  }
+
+  if (profile->symbolCount) {
+    qsort(routines, profile->symbolCount + 1, sizeof(profile_entry_t),
+          compareEntries);
+    fprintf(out, "%-20s %12s %7s %12s %12s\n", "Label", "Executed", "%",
+            "Skipped", "Accesses");
+    for (int i = 0; i <= profile->symbolCount; i++) {
+      profile_entry_t *routine = &routines[i];
+      if (!routine->executed && !routine->skipped) {
+        continue;
+      }
+      fprintf(out, "%-20s %12" PRIu64 " %6.2f%% %12" PRIu64 " %12" PRIu64
+              "\n", routine->address ?
+                    profile->symbols[routine->address - 1].name : "(start)",
+              routine->executed, total.executed ?
+                                 100.0 * routine->executed / total.executed :
+                                 0.0,
+              routine->skipped, routine->accesses);
+    }
+  }
+
+  free(entries);
+  free(routines);
+}
@@ -0,0 +1,84 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "emulate.h"
+#include <inttypes.h>
+
+#define PROFILE_TOP_ENTRIES 20
+#define SYMBOL_SUFFIX ".sym" // symbol file written by assemble --symbols
+#define MAX_LABEL_LENGTH 512
+#define NO_SYMBOL -1
+
+/*-------------TypeDefinitions------------------*/
+typedef struct profile_symbol profile_symbol_t;
+
+typedef struct profile_entry profile_entry_t;
+
+/*-------------Defining the profile-------------*/
+struct profile_symbol {
+  uint32_t address;
+  char *name;
+};
+
+struct profile_entry {
+  uint32_t address;
+  uint64_t executed;
+  uint64_t skipped;
+  uint64_t accesses;
+};
+
+struct profile {
+  uint64_t executed[MEM_SIZE_WORDS];
+  uint64_t skipped[MEM_SIZE_WORDS];
+  uint64_t accesses[MEM_SIZE_WORDS];
+  int current;
+  profile_symbol_t *symbols;
+  int symbolCount;
+};
+
+/*------------------Prototypes-------------------*/
+profile_t *createProfile(void);
+/*returns a profile with every counter at 0 and no symbols*/
+
+void destroyProfile(profile_t *profile);
+/*frees the profile and its symbols*/
+
+bool loadSymbols(profile_t *profile, const char *path);
+/*reads the "<address> <label>" lines of the symbol file at path. Returns
+  false if there is no such file*/
+
+int findSymbol(profile_t *profile, uint32_t address);
+/*returns the index of the last label at or before address or NO_SYMBOL*/
+
+void printLocation(profile_t *profile, uint32_t address, FILE *out);
+/*prints the label of address and the offset from it, then a new line*/
+
+void printProfile(profile_t *profile, FILE *out);
+/*prints the PROFILE_TOP_ENTRIES instructions run the most and the counters
+  of every label, sorted by the number of instructions run*/
+
+static inline void profileInstruction(profile_t *profile, int address,
+                                      bool executed) {
+  int index = address / 4;
+  if (index < 0 || index >= MEM_SIZE_WORDS) {
+    profile->current = -1;
+    return;
+  }
+  profile->current = index;
+  if (executed) {
+    profile->executed[index]++;
+  } else {
+    profile->skipped[index]++;
+  }
+}
+/*counts the instruction at address, executed or skipped because its
+  condition failed. Just an increment so that it can stay on in long runs*/
+
+static inline void profileMemoryAccess(profile_t *profile) {
+  if (profile->current >= 0) {
+    profile->accesses[profile->current]++;
+  }
+}
+/*counts a load or store of the instruction being executed*/
+
+#endif
@@ -0,0 +1,164 @@
+#include "sample.h"
+
+//written by the SIGPROF handler only, read once the timer is stopped
+static const proc_state_t *volatile sampledState;
+static uint32_t *samples;
+static volatile sig_atomic_t sampleCount;
+static volatile sig_atomic_t droppedSamples;
+
+static void recordSample(int signal) {
+  (void) signal;
+  if (sampleCount < MAX_SAMPLES) {
+    //a pipeline refill after a branch counts for the branch
+    samples[sampleCount] = sampledState->executing;
+    sampleCount++;
+  } else {
+    droppedSamples++;
+  }
+}
+
+//--------------Timer----------------------------------------------------------
+static void setTimer(int rate) {
+  struct itimerval timer = {{0, 0}, {0, 0}};
+  if (rate) {
+    timer.it_interval.tv_sec = 1 / rate;
+    timer.it_interval.tv_usec = 1000000 / rate % 1000000;
+    timer.it_value = timer.it_interval;
+  }
+  if (setitimer(ITIMER_PROF, &timer, NULL)) {
+    perror("setitimer");
+    exit(EXIT_FAILURE);
+  }
+}
+
+void startSampler(const proc_state_t *pState, int rate) {
+  samples = malloc(MAX_SAMPLES * sizeof(uint32_t));
+  if (!samples) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+  sampledState = pState;
+  sampleCount = 0;
+  droppedSamples = 0;
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = recordSample;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  if (sigaction(SIGPROF, &action, NULL)) {
+    perror("sigaction");
+    exit(EXIT_FAILURE);
+  }
+  setTimer(rate);
+}
+
+void stopSampler(void) {
+  setTimer(0);
+  signal(SIGPROF, SIG_IGN);
+}
+
+void freeSamples(void) {
+  free(samples);
+  samples = NULL;
+}
+
+//--------------Report---------------------------------------------------------
+//the profile counts the samples of every address as executed instructions
+static void countSamples(profile_t *profile) {
+  memset(profile->executed, 0, sizeof(profile->executed));
+  for (int i = 0; i < sampleCount; i++) {
+    if (samples[i] / 4 < MEM_SIZE_WORDS) {
+      profile->executed[samples[i] / 4]++;
+    }
+  }
+}
+
+static int compareCounts(const void *a, const void *b) {
+  const profile_entry_t *x = a;
+  const profile_entry_t *y = b;
+  if (x->executed != y->executed) {
+    return x->executed > y->executed ? -1 : 1;
+  }
+  return x->address < y->address ? -1 : x->address > y->address;
+}
+
+static double percentage(uint64_t count) {
+  return sampleCount ? 100.0 * count / sampleCount : 0.0;
+}
+
+void printSamples(profile_t *profile, FILE *out) {
+  profile_entry_t *entries = malloc(MEM_SIZE_WORDS * sizeof(profile_entry_t));
+  //indexed by the label + 1 like in printProfile
+  profile_entry_t *routines = calloc(profile->symbolCount + 1,
+                                     sizeof(profile_entry_t));
+  if (!entries || !routines) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+  countSamples(profile);
+
+  int count = 0;
+  for (int i = 0; i < MEM_SIZE_WORDS; i++) {
+    if (!profile->executed[i]) {
+      continue;
+    }
+    profile_entry_t entry = {i * 4, profile->executed[i], 0, 0};
+    entries[count++] = entry;
+    int label = findSymbol(profile, i * 4) + 1;
+    routines[label].address = label;
+    routines[label].executed += entry.executed;
+  }
+  qsort(entries, count, sizeof(profile_entry_t), compareCounts);
+
+  fprintf(out, "Samples: %d, %d dropped\n", (int) sampleCount,
+          (int) droppedSamples);
+  fprintf(out, "%-10s %12s %7s  %s\n", "Address", "Samples", "%",
+          "Location");
+  for (int i = 0; i < count && i < PROFILE_TOP_ENTRIES; i++) {
+    fprintf(out, "0x%.8x %12" PRIu64 " %6.2f%%", entries[i].address,
+            entries[i].executed, percentage(entries[i].executed));
+    printLocation(profile, entries[i].address, out);
+  }
+
+  if (profile->symbolCount) {
+    qsort(routines, profile->symbolCount + 1, sizeof(profile_entry_t),
+          compareCounts);
+    fprintf(out, "%-20s %12s %7s\n", "Label", "Samples", "%");
+    for (int i = 0; i <= profile->symbolCount && routines[i].executed; i++) {
+      fprintf(out, "%-20s %12" PRIu64 " %6.2f%%\n", routines[i].address ?
+              profile->symbols[routines[i].address - 1].name : "(start)",
+              routines[i].executed, percentage(routines[i].executed));
+    }
+  }
+
+  free(entries);
+  free(routines);
+}
+
+bool writeFoldedStacks(profile_t *profile, const char *path) {
+  FILE *file = fopen(path, "w");
+  if (!file) {
+    return false;
+  }
+  countSamples(profile);
+
+  for (int i = 0; i < MEM_SIZE_WORDS; i++) {
+    if (!profile->executed[i]) {
+      continue;
+    }
+    //the label is the caller frame of its instructions
+    int symbol = findSymbol(profile, i * 4);
+    if (symbol == NO_SYMBOL) {
+      fprintf(file, "%s;0x%.8x", FOLDED_ROOT, i * 4);
+    } else {
+      const profile_symbol_t *label = &profile->symbols[symbol];
+      fprintf(file, "%s;%s;%s+0x%x", FOLDED_ROOT, label->name, label->name,
+              i * 4 - label->address);
+    }
+    fprintf(file, " %" PRIu64 "\n", profile->executed[i]);
+  }
+
+  fclose(file);
+  return true;
+}
@@ -0,0 +1,34 @@
+#ifndef SAMPLE_H
+#define SAMPLE_H
+
+#include "profile.h"
+#include <signal.h>
+#include <sys/time.h>
+
+#define DEFAULT_SAMPLE_RATE 1000 // samples per second of CPU time
+#define MAX_SAMPLE_RATE 1000000
+#define MAX_SAMPLES (1 << 22) // 70 minutes at the default rate
+#define FOLDED_SUFFIX ".folded"
+#define FOLDED_ROOT "emulate"
+
+/*------------------Prototypes-------------------*/
+void startSampler(const proc_state_t *pState, int rate);
+/*records the address of the instruction pState executes rate times a second
+  of CPU time, from a SIGPROF handler. Storing a sample is a single write to
+  a buffer allocated here, so that the emulation runs at full speed*/
+
+void stopSampler(void);
+/*stops the timer, the samples stay in the buffer*/
+
+void printSamples(profile_t *profile, FILE *out);
+/*prints the addresses sampled the most and the samples of every label of
+  profile, whose counters are replaced by the samples*/
+
+bool writeFoldedStacks(profile_t *profile, const char *path);
+/*writes one "emulate;label;label+offset count" line per sampled address to
+  path, which flamegraph.pl reads. Returns false if path can't be written*/
+
+void freeSamples(void);
+/*frees the buffer of samples*/
+
+#endif
@@ -0,0 +1,245 @@
+#include "schedule.h"
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+// --------------------------OPERANDS-----------------------------
+/* Returns the mask of the register in the 4 bits of word at shift */
+static uint32_t registerAt(uint32_t word, int shift) {
+  return 1u << ((word >> shift) & 0xF);
+}
+
+bool getOperands(const program *prog, uint32_t address, operands *ops) {
+  uint32_t word = prog->words[address];
+  uint32_t opcode = (word >> 21) & 0xF;
+  operands o = {0, 0, false, ALU_LATENCY, 1};
+
+  if (prog->data[address] || !word || isBranch(word) || writesPc(word)) {
+    return false;
+  }
+
+  if (isMultiply(word)) {
+    o.uses = registerAt(word, 0) | registerAt(word, 8);
+    if (word & ACCUMULATE_BIT) {
+      o.uses |= registerAt(word, 12);
+    }
+    o.defines = registerAt(word, 16);
+    o.latency = MULTIPLY_LATENCY;
+  } else if (isDataProcessing(word)) {
+    if (opcode != MOV_OPCODE && opcode != MVN_OPCODE) {
+      o.uses |= registerAt(word, 16);
+    }
+    if (!(word & IMMEDIATE_BIT)) {
+      o.uses |= registerAt(word, 0);
+      if (word & SHIFT_BY_REGISTER_BIT) {
+        o.uses |= registerAt(word, 8);
+        o.issue = SHIFT_BY_REGISTER_ISSUE;
+      }
+    }
+    if (opcode < TST_OPCODE || opcode > CMN_OPCODE) {
+      o.defines |= registerAt(word, 12);
+    }
+    if (opcode >= ADC_OPCODE && opcode <= RSC_OPCODE) {
+      // adc, sbc and rsc read the carry
+      o.uses |= FLAGS_MASK;
+    }
+  } else if (((word >> 26) & 0x3) == 1) {
+    o.uses |= registerAt(word, 16);
+    if (word & IMMEDIATE_BIT) {
+      // register offset
+      o.uses |= registerAt(word, 0);
+    }
+    if (!(word & PRE_INDEX_BIT) || (word & WRITE_BACK_BIT)) {
+      o.defines |= registerAt(word, 16);
+    }
+    if (word & LOAD_BIT) {
+      o.defines |= registerAt(word, 12);
+      o.latency = LOAD_LATENCY;
+    } else {
+      o.uses |= registerAt(word, 12);
+    }
+    o.memory = true;
+
+    if (isPcRelative(word)) {
+      // the offset is fixed once the instruction has moved
+      int64_t target = transferAddress(word, address) / MEMORY_SIZE;
+      o.uses &= ~registerAt(PC_REGISTER, 0);
+      // nothing writes to a pool
+      o.memory = !(word & LOAD_BIT) || target < 0 || target >= prog->size ||
+                 !prog->data[target];
+    }
+  } else {
+    return false;
+  }
+
+  if (setsFlags(word)) {
+    o.defines |= FLAGS_MASK;
+  }
+  if (conditionOf(word) != AL_CONDITION) {
+    // when it doesn't run the registers keep their old values
+    o.uses |= FLAGS_MASK | (o.defines & ~FLAGS_MASK);
+  }
+  if ((o.uses | o.defines) & registerAt(PC_REGISTER, 0)) {
+    return false;
+  }
+
+  *ops = o;
+  return true;
+}
+
+// --------------------------SCHEDULING---------------------------
+/**
+* Returns the cycles the n nodes take when issued in order, one at a time.
+* results[k] is the mask of the nodes whose result k uses
+**/
+static int blockCycles(const scheduleNode *nodes, const int *order, int n,
+                       const uint32_t *results) {
+  int issued[MAX_SCHEDULE_WINDOW];
+  int cycle = 0;
+
+  for (int i = 0; i < n; i++) {
+    int k = order[i];
+    int start = cycle;
+    for (int j = 0; j < n; j++) {
+      if ((results[k] >> j) & 1 &&
+          issued[j] + nodes[j].ops.latency > start) {
+        start = issued[j] + nodes[j].ops.latency;
+      }
+    }
+    issued[k] = start;
+    cycle = start + nodes[k].ops.issue;
+  }
+
+  return cycle;
+}
+
+/**
+* Finds an order for the n nodes by list scheduling: after[k] is the mask
+* of the nodes which have to go before k. The next instruction is the one
+* which can issue the soonest, then the one with the longest chain after
+* it, then the first one
+**/
+static void listSchedule(scheduleNode *nodes, int n, const uint32_t *after,
+                         const uint32_t *results, int *order) {
+  uint32_t scheduled = 0;
+  int cycle = 0;
+
+  for (int k = n - 1; k >= 0; k--) {
+    nodes[k].priority = nodes[k].ops.latency;
+    for (int m = k + 1; m < n; m++) {
+      int edge = (results[m] >> k) & 1 ? nodes[k].ops.latency
+                                       : nodes[k].ops.issue;
+      if ((after[m] >> k) & 1 &&
+          edge + nodes[m].priority > nodes[k].priority) {
+        nodes[k].priority = edge + nodes[m].priority;
+      }
+    }
+    nodes[k].ready = 0;
+  }
+
+  for (int i = 0; i < n; i++) {
+    int best = -1;
+    int bestStart = 0;
+
+    for (int k = 0; k < n; k++) {
+      int start = nodes[k].ready > cycle ? nodes[k].ready : cycle;
+      if ((scheduled >> k) & 1 || (after[k] & ~scheduled)) {
+        continue;
+      }
+      if (best < 0 || start < bestStart ||
+          (start == bestStart && nodes[k].priority > nodes[best].priority)) {
+        best = k;
+        bestStart = start;
+      }
+    }
+
+    order[i] = best;
+    scheduled |= 1u << best;
+    cycle = bestStart + nodes[best].ops.issue;
+    for (int m = 0; m < n; m++) {
+      int ready = bestStart + nodes[best].ops.latency;
+      if ((results[m] >> best) & 1 && nodes[m].ready < ready) {
+        nodes[m].ready = ready;
+      }
+    }
+  }
+}
+
+/* Schedules the n instructions of the block at start */
+static void scheduleBlock(program *prog, uint32_t start, int n) {
+  scheduleNode nodes[MAX_SCHEDULE_WINDOW];
+  uint32_t after[MAX_SCHEDULE_WINDOW];
+  uint32_t results[MAX_SCHEDULE_WINDOW];
+  int original[MAX_SCHEDULE_WINDOW];
+  int order[MAX_SCHEDULE_WINDOW];
+  uint32_t words[MAX_SCHEDULE_WINDOW];
+
+  for (int k = 0; k < n; k++) {
+    nodes[k].word = prog->words[start + k];
+    getOperands(prog, start + k, &nodes[k].ops);
+    original[k] = k;
+    after[k] = 0;
+    results[k] = 0;
+
+    for (int j = 0; j < k; j++) {
+      const operands *first = &nodes[j].ops;
+      const operands *second = &nodes[k].ops;
+      if (first->defines & second->uses) {
+        results[k] |= 1u << j;
+      }
+      if ((first->defines & (second->uses | second->defines)) ||
+          (first->uses & second->defines) ||
+          (first->memory && second->memory)) {
+        after[k] |= 1u << j;
+      }
+    }
+  }
+
+  listSchedule(nodes, n, after, results, order);
+  if (blockCycles(nodes, order, n, results) >=
+      blockCycles(nodes, original, n, results)) {
+    return;
+  }
+
+  for (int i = 0; i < n; i++) {
+    int k = order[i];
+    uint32_t word = nodes[k].word;
+
+    if (isPcRelative(word)) {
+      // the accessed word stays where it is
+      int64_t offset = transferAddress(word, start + k) -
+                       (int64_t) (start + i + PC_OFFSET) * MEMORY_SIZE;
+      if (offset > TRANSFER_OFFSET_MASK || -offset > TRANSFER_OFFSET_MASK) {
+        return;
+      }
+      word &= ~(UP_BIT | TRANSFER_OFFSET_MASK);
+      word |= offset >= 0 ? UP_BIT | offset : -offset;
+    }
+    words[i] = word;
+  }
+
+  memcpy(prog->words + start, words, n * sizeof(uint32_t));
+}
+
+void scheduleProgram(program *prog, const map *labelMapping) {
+  bool *targets = jumpTargets(prog, labelMapping);
+  operands ops;
+  uint32_t i = 0;
+
+  while (i < prog->size) {
+    if (!getOperands(prog, i, &ops)) {
+      i++;
+      continue;
+    }
+
+    // a block ends before anything which can't move or can be jumped to
+    uint32_t start = i++;
+    while (i < prog->size && i - start < MAX_SCHEDULE_WINDOW &&
+           !targets[i] && getOperands(prog, i, &ops)) {
+      i++;
+    }
+    if (i - start > 1) {
+      scheduleBlock(prog, start, i - start);
+    }
+  }
+
+  free(targets);
+}
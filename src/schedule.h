@@ -0,0 +1,69 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include "optimise.h"
+
+// ---------------------------MACROS-----------------------------
+// ARM1176 result latencies: the number of cycles after its issue the result
+// of an instruction can be used by another one
+#define ALU_LATENCY 1
+#define LOAD_LATENCY 3
+#define MULTIPLY_LATENCY 4
+// a shift by a register takes an extra issue cycle
+#define SHIFT_BY_REGISTER_ISSUE 2
+// at most this many instructions are reordered together
+#define MAX_SCHEDULE_WINDOW 32
+// the flags are tracked as an extra register in the masks
+#define FLAGS_MASK (1u << 16)
+
+// -------------------------TYPES---------------------------------
+typedef struct operands operands;
+typedef struct scheduleNode scheduleNode;
+
+// -------------------------STRUCTS-------------------------------
+/**
+* What an instruction reads and writes: uses and defines are masks of
+* registers (bit r) and of the flags (FLAGS_MASK). memory is set for the
+* loads and stores which must stay in order (the MMIO registers are memory
+* too), the loads from a literal pool are not. latency is when the result
+* can be used and issue how many cycles the instruction takes to issue
+**/
+struct operands {
+  uint32_t uses;
+  uint32_t defines;
+  bool     memory;
+  int      latency;
+  int      issue;
+};
+
+/**
+* An instruction of the block being scheduled: priority is the longest
+* latency chain from it to the end of the block and ready the first cycle
+* its operands are available
+**/
+struct scheduleNode {
+  uint32_t word;
+  operands ops;
+  int      priority;
+  int      ready;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+/**
+* Reorders the instructions of every basic block of prog to hide the
+* latency of loads and multiplies. An instruction never moves past another
+* one whose registers or flags it depends on, or which depends on its own,
+* and the loads and stores stay in order. A block is only changed if it
+* takes fewer cycles. Nothing can jump into a block so the labels don't
+* move
+**/
+void scheduleProgram(program *prog, const map *labelMapping);
+
+/**
+* Returns the operands of the instruction at address
+* Returns false if the instruction can't be moved (a branch, a halt or
+* anything using the pc but a load from a literal pool)
+**/
+bool getOperands(const program *prog, uint32_t address, operands *ops);
+
+#endif
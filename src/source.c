@@ -0,0 +1,118 @@
+#include "source.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+bool openSource(const char *path, sourceFile *source) {
+  struct stat info;
+  int fd = open(path, O_RDONLY);
+
+  if (fd < 0) {
+    return false;
+  }
+
+  if (fstat(fd, &info) < 0) {
+    close(fd);
+    return false;
+  }
+
+  source->size = info.st_size;
+  source->data = "";
+  if (source->size) {
+    void *data = mmap(NULL, source->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    // both passes read the file from start to end
+    madvise(data, source->size, MADV_SEQUENTIAL);
+    source->data = data;
+  }
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+
+  indexLines(source);
+  return true;
+}
+
+void closeSource(sourceFile *source) {
+  if (source->size) {
+    munmap((void *) source->data, source->size);
+  }
+  free(source->lineStarts);
+  source->lineStarts = NULL;
+  source->lineCount = 0;
+}
+
+const char *getLine(const sourceFile *source, uint32_t line, int *length) {
+  *length = source->lineStarts[line + 1] - source->lineStarts[line];
+  return source->data + source->lineStarts[line];
+}
+
+static void addLineStart(sourceFile *source, size_t *capacity, size_t start) {
+  if (source->lineCount + 1 >= *capacity) {
+    *capacity *= 2;
+    size_t *lineStarts = realloc(source->lineStarts,
+                                 *capacity * sizeof(size_t));
+    if (!lineStarts) {
+      perror("realloc");
+      exit(EXIT_FAILURE);
+    }
+    source->lineStarts = lineStarts;
+  }
+
+  source->lineStarts[source->lineCount++] = start;
+}
+
+void indexLines(sourceFile *source) {
+  // guess one line every 16 characters, the index grows if needed
+  size_t capacity = source->size / 16 + 2;
+  size_t i = 0;
+
+  source->lineCount = 0;
+  source->lineStarts = malloc(capacity * sizeof(size_t));
+  if (!source->lineStarts) {
+    perror("malloc");
+    exit(EXIT_FAILURE);
+  }
+
+  if (source->size) {
+    addLineStart(source, &capacity, 0);
+  }
+
+#ifdef __SSE2__
+  const __m128i newLine = _mm_set1_epi8('\n');
+  for (; i + 16 <= source->size; i += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *) (source->data + i));
+    unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newLine));
+
+    while (mask) {
+      // every set bit is a new line in the chunk
+      size_t end = i + __builtin_ctz(mask);
+      if (end + 1 < source->size) {
+        addLineStart(source, &capacity, end + 1);
+      }
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  while (i < source->size) {
+    const char *end = memchr(source->data + i, '\n', source->size - i);
+    if (!end) {
+      break;
+    }
+    i = end - source->data + 1;
+    if (i < source->size) {
+      addLineStart(source, &capacity, i);
+    }
+  }
+
+  // sentinel so that the last line has an end
+  source->lineStarts[source->lineCount] = source->size;
+}
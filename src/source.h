@@ -0,0 +1,44 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include "headers.h"
+
+// -------------------------TYPES---------------------------------
+typedef struct sourceFile sourceFile;
+
+// -------------------------STRUCTS-------------------------------
+/**
+* A source file mapped read only into memory. lineStarts holds the offset of
+* the first character of every line followed by the size of the file, so
+* line i is the slice [lineStarts[i], lineStarts[i + 1])
+**/
+struct sourceFile {
+  const char *data;
+  size_t     size;
+  size_t     *lineStarts;
+  uint32_t   lineCount;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+/**
+* Maps the file at path and indexes its lines
+* Returns false if the file can't be opened or mapped
+**/
+bool openSource(const char *path, sourceFile *source);
+
+/* Unmaps the file and frees the line index */
+void closeSource(sourceFile *source);
+
+/**
+* Returns a pointer to the first character of line (counting from 0) and
+* its length (including the new line character) through length
+**/
+const char *getLine(const sourceFile *source, uint32_t line, int *length);
+
+/**
+* Fills lineStarts with the offset of every line of data, scanning 16 bytes
+* at a time for new lines when SSE2 is available
+**/
+void indexLines(sourceFile *source);
+
+#endif
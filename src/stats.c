@@ -0,0 +1,139 @@
+#include "stats.h"
+#include "instructionManipulation.h"
+
+static const char *OPCODE_NAMES[OPCODES] = {
+  "and", "eor", "sub", "rsb", "add", "adc", "sbc", "rsc",
+  "tst", "teq", "cmp", "cmn", "orr", "mov", "bic", "mvn"
+};
+
+//only the conditions shouldExecute knows
+static const char *CONDITION_NAMES[CONDITIONS] = {
+  "eq", "ne", NULL, NULL, NULL, NULL, NULL, NULL,
+  NULL, NULL, "ge", "lt", "gt", "le", "al", NULL
+};
+
+const char *const DEVICE_NAMES[DEVICES] = {
+  "gpio0_9", "gpio10_19", "gpio20_29", "gpioOn", "gpioOff"
+};
+
+static const int DEVICE_ADDRESSES[DEVICES] = {
+  GPIOo_9_ADDRESS, GPIO10_19_ADDRESS, GPIO20_29_ADDRESS, GPIO_OUTPUT_ON,
+  GPIO_OUTPUT_OFF
+};
+
+stats_t *createStats(void) {
+  stats_t *stats = calloc(1, sizeof(stats_t));
+  if (!stats) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  return stats;
+}
+
+void startStats(stats_t *stats) {
+  clock_gettime(CLOCK_MONOTONIC, &stats->start);
+}
+
+void stopStats(stats_t *stats) {
+  clock_gettime(CLOCK_MONOTONIC, &stats->end);
+}
+
+//--------------Counting-------------------------------------------------------
+void countInstruction(stats_t *stats, int instruction, bool executed) {
+  uint8_t condition = getCond(instruction);
+  int idBits = extractIDbits(instruction);
+  if (!executed) {
+    stats->skipped++;
+    stats->conditionFailed[condition]++;
+    stats->branchesNotTaken += idBits == 2;
+    return;
+  }
+
+  stats->retired++;
+  stats->conditionPassed[condition]++;
+  if (idBits == 2) {
+    stats->branchesTaken++;
+  } else if (!idBits && isMult(instruction)) {
+    if (instruction & A_BIT) {
+      stats->multiplyAccumulate++;
+    } else {
+      stats->multiply++;
+    }
+    stats->flagSetting += (instruction & S_BIT) != 0;
+  } else if (!idBits) {
+    stats->dataProcessing[getOpcode(instruction)]++;
+    stats->flagSetting += (instruction & S_BIT) != 0;
+  }
+}
+
+int deviceOf(int address) {
+  for (int i = 0; i < DEVICES; i++) {
+    if (address == DEVICE_ADDRESSES[i]) {
+      return i;
+    }
+  }
+  return NO_DEVICE;
+}
+
+void countTransfer(stats_t *stats, int address, bool store) {
+  int device = deviceOf(address);
+  if (store) {
+    stats->stores++;
+  } else {
+    stats->loads++;
+  }
+  if (device == NO_DEVICE) {
+    return;
+  }
+  if (store) {
+    stats->devices[device].stores++;
+  } else {
+    stats->devices[device].loads++;
+  }
+}
+
+//--------------Report---------------------------------------------------------
+void printStats(stats_t *stats, FILE *out) {
+  double seconds = (stats->end.tv_sec - stats->start.tv_sec) +
+                   (stats->end.tv_nsec - stats->start.tv_nsec) / 1e9;
+
+  fprintf(out, "{\n  \"instructions\": {\"retired\": %" PRIu64
+          ", \"skipped\": %" PRIu64 "},\n", stats->retired, stats->skipped);
+  fprintf(out, "  \"dataProcessing\": {");
+  for (int i = 0; i < OPCODES; i++) {
+    fprintf(out, "%s\"%s\": %" PRIu64, i ? ", " : "", OPCODE_NAMES[i],
+            stats->dataProcessing[i]);
+  }
+  fprintf(out, "},\n  \"multiply\": {\"mul\": %" PRIu64 ", \"mla\": %"
+          PRIu64 "},\n", stats->multiply, stats->multiplyAccumulate);
+  fprintf(out, "  \"transfer\": {\"ldr\": %" PRIu64 ", \"str\": %" PRIu64
+          "},\n", stats->loads, stats->stores);
+  fprintf(out, "  \"branches\": {\"taken\": %" PRIu64 ", \"notTaken\": %"
+          PRIu64 "},\n", stats->branchesTaken, stats->branchesNotTaken);
+
+  fprintf(out, "  \"conditions\": {");
+  bool first = true;
+  for (int i = 0; i < CONDITIONS; i++) {
+    if (!CONDITION_NAMES[i]) {
+      continue;
+    }
+    uint64_t total = stats->conditionPassed[i] + stats->conditionFailed[i];
+    fprintf(out, "%s\n    \"%s\": {\"passed\": %" PRIu64 ", \"failed\": %"
+            PRIu64 ", \"passRate\": %.4f}", first ? "" : ",",
+            CONDITION_NAMES[i], stats->conditionPassed[i],
+            stats->conditionFailed[i],
+            total ? (double) stats->conditionPassed[i] / total : 0.0);
+    first = false;
+  }
+  fprintf(out, "\n  },\n  \"flagSetting\": %" PRIu64 ",\n",
+          stats->flagSetting);
+
+  fprintf(out, "  \"mmio\": {");
+  for (int i = 0; i < DEVICES; i++) {
+    fprintf(out, "%s\n    \"%s\": {\"loads\": %" PRIu64 ", \"stores\": %"
+            PRIu64 "}", i ? "," : "", DEVICE_NAMES[i],
+            stats->devices[i].loads, stats->devices[i].stores);
+  }
+  fprintf(out, "\n  },\n  \"host\": {\"seconds\": %.6f, \"mips\": %.3f}\n}\n",
+          seconds, seconds > 0 ? stats->retired / seconds / 1e6 : 0.0);
+}
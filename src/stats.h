@@ -0,0 +1,78 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "emulate.h"
+#include <inttypes.h>
+#include <time.h>
+
+#define OPCODES 16
+#define CONDITIONS 16
+#define S_BIT (1 << 20)
+#define A_BIT (1 << 21)
+#define NO_DEVICE -1
+#define STATS_SUFFIX ".stats.json"
+
+/*-------------TypeDefinitions------------------*/
+typedef struct device_counts device_counts_t;
+
+/*-------------Defining the statistics----------*/
+//the MMIO registers, in the order of DEVICE_ADDRESSES
+enum device {
+  GPIO_0_9,
+  GPIO_10_19,
+  GPIO_20_29,
+  GPIO_ON,
+  GPIO_OFF,
+  DEVICES //the number of devices, not one of them
+};
+
+struct device_counts {
+  uint64_t loads;
+  uint64_t stores;
+};
+
+struct stats {
+  uint64_t retired;
+  uint64_t skipped;
+  uint64_t dataProcessing[OPCODES];
+  uint64_t multiply;
+  uint64_t multiplyAccumulate;
+  uint64_t loads;
+  uint64_t stores;
+  uint64_t branchesTaken;
+  uint64_t branchesNotTaken;
+  uint64_t conditionPassed[CONDITIONS];
+  uint64_t conditionFailed[CONDITIONS];
+  uint64_t flagSetting;
+  device_counts_t devices[DEVICES];
+  struct timespec start;
+  struct timespec end;
+};
+
+extern const char *const DEVICE_NAMES[DEVICES];
+
+/*------------------Prototypes-------------------*/
+stats_t *createStats(void);
+/*returns statistics with every counter at 0*/
+
+void startStats(stats_t *stats);
+/*starts the host clock of the run*/
+
+void stopStats(stats_t *stats);
+/*stops the host clock of the run*/
+
+void countInstruction(stats_t *stats, int instruction, bool executed);
+/*counts the instruction in its class, its condition and if it was retired
+  or skipped*/
+
+int deviceOf(int address);
+/*returns the device of the MMIO register at address or NO_DEVICE*/
+
+void countTransfer(stats_t *stats, int address, bool store);
+/*counts a load or store and the device it accesses if any*/
+
+void printStats(stats_t *stats, FILE *out);
+/*prints the counters, the host time of the run and the guest MIPS as a JSON
+  object*/
+
+#endif
@@ -0,0 +1,134 @@
+#include "timing.h"
+#include "instructionManipulation.h"
+
+timing_t *createTiming(int clockMhz, uint64_t maxCycles) {
+  timing_t *timing = calloc(1, sizeof(timing_t));
+  if (!timing) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  timing->clockMhz = clockMhz;
+  timing->maxCycles = maxCycles;
+  timing->lastOn = NO_PIN_EVENT;
+  timing->minPeriod = UINT64_MAX;
+  return timing;
+}
+
+//--------------Instructions---------------------------------------------------
+/* Waits until the register can be read, counting the stall */
+static void use(timing_t *timing, int reg) {
+  if (timing->ready[reg] > timing->cycles) {
+    uint64_t stall = timing->ready[reg] - timing->cycles;
+    if (timing->multiplied[reg]) {
+      timing->multiplyStalls += stall;
+    } else {
+      timing->loadStalls += stall;
+    }
+    timing->cycles = timing->ready[reg];
+  }
+}
+
+/* Makes the register readable from the cycle ready */
+static void define(timing_t *timing, int reg, uint64_t ready,
+                   bool multiplied) {
+  timing->ready[reg] = ready;
+  timing->multiplied[reg] = multiplied;
+}
+
+void timeInstruction(timing_t *timing, int instruction, bool executed) {
+  int idBits = extractIDbits(instruction);
+  timing->instructions++;
+  if (!executed) {
+    timing->cycles += SKIPPED_CYCLES;
+    return;
+  }
+
+  if (idBits == 2) {
+    timing->cycles += BRANCH_CYCLES;
+  } else if (!idBits && isMult(instruction)) {
+    use(timing, getRmMul(instruction));
+    use(timing, getRsMul(instruction));
+    if (getABit(instruction)) {
+      use(timing, getRnMul(instruction));
+    }
+    define(timing, getRdMul(instruction),
+           timing->cycles + MULTIPLY_RESULT_LATENCY, true);
+    timing->cycles += MULTIPLY_CYCLES;
+  } else if (!idBits) {
+    int opcode = getOpcode(instruction);
+    int cycles = ALU_CYCLES;
+    if (opcode != MOV_OPCODE && opcode != MVN_OPCODE) {
+      use(timing, getRn(instruction));
+    }
+    if (!getIBit(instruction)) {
+      use(timing, getRm(instruction));
+      if (getLSbit(getShift(instruction))) {
+        use(timing, getShiftRegister(instruction));
+        cycles = SHIFT_BY_REGISTER_CYCLES;
+      }
+    }
+    timing->cycles += cycles;
+    //tst, teq, cmp and cmn only set the flags
+    if (opcode < TST_OPCODE || opcode > CMN_OPCODE) {
+      define(timing, getRdest(instruction), timing->cycles, false);
+    }
+  } else {
+    int Rd = getRdSingle(instruction);
+    use(timing, getRn(instruction));
+    if (getISingle(instruction)) {
+      use(timing, getRm(instruction));
+    }
+    if (!getLBit(instruction)) {
+      use(timing, Rd);
+    }
+    if (getLBit(instruction)) {
+      define(timing, Rd, timing->cycles + LOAD_RESULT_LATENCY, false);
+    }
+    timing->cycles += TRANSFER_CYCLES;
+    if (!getPBit(instruction)) {
+      //post indexing writes the base back
+      define(timing, getRn(instruction), timing->cycles, false);
+    }
+  }
+}
+
+void timePinOn(timing_t *timing) {
+  if (timing->lastOn != NO_PIN_EVENT) {
+    uint64_t period = timing->cycles - timing->lastOn;
+    timing->periods++;
+    timing->totalPeriods += period;
+    timing->minPeriod = period < timing->minPeriod ? period
+                                                   : timing->minPeriod;
+    timing->maxPeriod = period > timing->maxPeriod ? period
+                                                   : timing->maxPeriod;
+  }
+  timing->lastOn = timing->cycles;
+}
+
+//--------------Report---------------------------------------------------------
+/* Returns the microseconds the cycles take at the clock */
+static double microseconds(timing_t *timing, uint64_t cycles) {
+  return (double) cycles / timing->clockMhz;
+}
+
+void printTiming(timing_t *timing, FILE *out) {
+  fprintf(out, "Timing: %" PRIu64 " cycles for %" PRIu64 " instructions, "
+          "CPI %.3f\n", timing->cycles, timing->instructions,
+          timing->instructions ? (double) timing->cycles /
+                                 timing->instructions : 0.0);
+  fprintf(out, "Stalls: %" PRIu64 " load use, %" PRIu64 " multiply, %"
+          PRIu64 " branch flush cycles\n", timing->loadStalls,
+          timing->multiplyStalls, timing->flushCycles);
+  fprintf(out, "Estimated time at %d MHz: %.3f us\n", timing->clockMhz,
+          microseconds(timing, timing->cycles));
+  if (timing->periods) {
+    fprintf(out, "Pin on period over %" PRIu64 " periods: min %.3f us, "
+            "average %.3f us, max %.3f us\n", timing->periods,
+            microseconds(timing, timing->minPeriod),
+            microseconds(timing, timing->totalPeriods) / timing->periods,
+            microseconds(timing, timing->maxPeriod));
+  }
+  if (timingExpired(timing)) {
+    fprintf(out, "Stopped after %" PRIu64 " cycles\n", timing->maxCycles);
+  }
+}
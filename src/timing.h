@@ -0,0 +1,70 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include "emulate.h"
+#include <inttypes.h>
+
+// ARM1176JZF-S costs in cycles: the issue cycles of every class and the
+// cycles until the result of a load or multiply can be used
+#define DEFAULT_CLOCK_MHZ 700 // Raspberry Pi 1
+#define SKIPPED_CYCLES 1 // a failed condition still issues
+#define ALU_CYCLES 1
+#define SHIFT_BY_REGISTER_CYCLES 2
+#define MULTIPLY_CYCLES 2
+#define MULTIPLY_RESULT_LATENCY 4
+#define TRANSFER_CYCLES 1
+#define LOAD_RESULT_LATENCY 3
+#define BRANCH_CYCLES 1
+#define BRANCH_FLUSH_CYCLES 7 // refilling the 8 stage pipeline
+#define NO_PIN_EVENT UINT64_MAX
+#define TST_OPCODE 0x8
+#define CMN_OPCODE 0xB
+#define MOV_OPCODE 0xD
+#define MVN_OPCODE 0xF
+
+/*-------------Defining the timing model--------*/
+struct timing {
+  int clockMhz;
+  uint64_t maxCycles; //0 for no limit
+  uint64_t cycles;
+  uint64_t instructions;
+  uint64_t loadStalls;
+  uint64_t multiplyStalls;
+  uint64_t flushCycles;
+  uint64_t ready[NUMBER_REGS]; //the first cycle each register can be read
+  bool multiplied[NUMBER_REGS]; //if a stall on the register is a multiply's
+  //the periods between the stores to GPIO_OUTPUT_ON
+  uint64_t lastOn;
+  uint64_t periods;
+  uint64_t minPeriod;
+  uint64_t maxPeriod;
+  uint64_t totalPeriods;
+};
+
+/*------------------Prototypes-------------------*/
+timing_t *createTiming(int clockMhz, uint64_t maxCycles);
+/*returns a timing model at clockMhz stopping after maxCycles if not 0*/
+
+void timeInstruction(timing_t *timing, int instruction, bool executed);
+/*adds the cycles of the instruction, waiting for the loads and multiplies
+  it depends on*/
+
+static inline void timeBranchFlush(timing_t *timing) {
+  timing->cycles += BRANCH_FLUSH_CYCLES;
+  timing->flushCycles += BRANCH_FLUSH_CYCLES;
+}
+/*adds the refill of the pipeline after a taken branch*/
+
+void timePinOn(timing_t *timing);
+/*records a store to GPIO_OUTPUT_ON at the current cycle*/
+
+static inline bool timingExpired(timing_t *timing) {
+  return timing->maxCycles && timing->cycles >= timing->maxCycles;
+}
+/*returns true once the limit of cycles is reached*/
+
+void printTiming(timing_t *timing, FILE *out);
+/*prints the cycles, the stalls, the estimated time at the clock and the
+  periods between the pin being turned on*/
+
+#endif
@@ -0,0 +1,152 @@
+#include "trace.h"
+
+//--------------Writer thread--------------------------------------------------
+static void *writeChunks(void *argument) {
+  trace_t *trace = argument;
+  pthread_mutex_lock(&trace->lock);
+  while (true) {
+    while (trace->tail == trace->head && !trace->stop) {
+      pthread_cond_wait(&trace->filled, &trace->lock);
+    }
+    if (trace->tail == trace->head) {
+      break;
+    }
+    //the emulator doesn't touch the chunks it has handed over
+    trace_chunk_t *chunk = &trace->chunks[trace->tail % TRACE_CHUNKS];
+    pthread_mutex_unlock(&trace->lock);
+    bool written = fwrite(chunk->bytes, 1, chunk->length, trace->file) ==
+                   (size_t) chunk->length;
+    pthread_mutex_lock(&trace->lock);
+    trace->failed |= !written;
+    trace->tail++;
+    pthread_cond_signal(&trace->drained);
+  }
+  pthread_mutex_unlock(&trace->lock);
+  return NULL;
+}
+
+/* Hands the chunk being filled to the writer and starts the next one. Only
+   waits if the writer is TRACE_CHUNKS chunks behind */
+static void submitChunk(trace_t *trace) {
+  pthread_mutex_lock(&trace->lock);
+  trace->head++;
+  pthread_cond_signal(&trace->filled);
+  while (trace->head - trace->tail == TRACE_CHUNKS) {
+    pthread_cond_wait(&trace->drained, &trace->lock);
+  }
+  pthread_mutex_unlock(&trace->lock);
+  trace->chunks[trace->head % TRACE_CHUNKS].length = 0;
+}
+
+trace_t *openTrace(const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    return NULL;
+  }
+  trace_t *trace = calloc(1, sizeof(trace_t));
+  if (!trace || !(trace->chunks = calloc(TRACE_CHUNKS,
+                                         sizeof(trace_chunk_t)))) {
+    perror("calloc");
+    exit(EXIT_FAILURE);
+  }
+  trace->file = file;
+  trace->pc = TRACE_START_PC;
+  pthread_mutex_init(&trace->lock, NULL);
+  pthread_cond_init(&trace->filled, NULL);
+  pthread_cond_init(&trace->drained, NULL);
+
+  trace_chunk_t *chunk = &trace->chunks[0];
+  memcpy(chunk->bytes, TRACE_MAGIC, TRACE_MAGIC_LENGTH);
+  chunk->bytes[TRACE_MAGIC_LENGTH] = TRACE_VERSION;
+  chunk->length = TRACE_MAGIC_LENGTH + 1;
+
+  if (pthread_create(&trace->writer, NULL, writeChunks, trace)) {
+    perror("pthread_create");
+    exit(EXIT_FAILURE);
+  }
+  return trace;
+}
+
+bool closeTrace(trace_t *trace) {
+  if (trace->chunks[trace->head % TRACE_CHUNKS].length) {
+    submitChunk(trace);
+  }
+  pthread_mutex_lock(&trace->lock);
+  trace->stop = true;
+  pthread_cond_signal(&trace->filled);
+  pthread_mutex_unlock(&trace->lock);
+  pthread_join(trace->writer, NULL);
+
+  bool written = !trace->failed & !fclose(trace->file);
+  pthread_mutex_destroy(&trace->lock);
+  pthread_cond_destroy(&trace->filled);
+  pthread_cond_destroy(&trace->drained);
+  free(trace->chunks);
+  free(trace);
+  return written;
+}
+
+//--------------Records--------------------------------------------------------
+static uint8_t *putVarint(uint8_t *out, uint32_t value) {
+  while (value >= 0x80) {
+    *out++ = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  *out++ = value;
+  return out;
+}
+
+static int flagsOf(proc_state_t *pState) {
+  return pState->NEG << 3 | pState->ZER << 2 | pState->CRY << 1 |
+         pState->OVF;
+}
+
+void traceInstruction(trace_t *trace, proc_state_t *pState, bool executed) {
+  trace_chunk_t *chunk = &trace->chunks[trace->head % TRACE_CHUNKS];
+  uint8_t *start = chunk->bytes + chunk->length;
+  uint8_t *out = start + 1;
+  uint8_t header = executed ? TRACE_EXECUTED : 0;
+
+  int pc = pState->executing;
+  if (pc != trace->pc + 4) {
+    header |= TRACE_JUMP;
+    out = putVarint(out, zigzag((pc - trace->pc - 4) / 4));
+  }
+  trace->pc = pc;
+
+  int flags = flagsOf(pState);
+  if (flags != trace->flags) {
+    header |= TRACE_FLAGS;
+    *out++ = flags;
+    trace->flags = flags;
+  }
+
+  int writes = 0;
+  for (int r = 0; r < TRACE_REGS && writes < TRACE_MAX_WRITES; r++) {
+    if (pState->regs[r] != trace->regs[r]) {
+      *out++ = r;
+      out = putVarint(out, zigzag((uint32_t) pState->regs[r] -
+                                  (uint32_t) trace->regs[r]));
+      trace->regs[r] = pState->regs[r];
+      writes++;
+    }
+  }
+  header |= writes << TRACE_WRITES_SHIFT;
+
+  if (trace->memory) {
+    header |= TRACE_MEMORY | (trace->store ? TRACE_STORE : 0);
+    out = putVarint(out, zigzag((uint32_t) trace->memoryAddress -
+                                (uint32_t) trace->address));
+    trace->address = trace->memoryAddress;
+    if (trace->store) {
+      out = putVarint(out, trace->memoryValue);
+    }
+    trace->memory = false;
+  }
+
+  *start = header;
+  chunk->length = out - chunk->bytes;
+  if (chunk->length > TRACE_CHUNK_SIZE - MAX_RECORD_LENGTH) {
+    submitChunk(trace);
+  }
+}
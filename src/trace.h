@@ -0,0 +1,101 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "emulate.h"
+#include <inttypes.h>
+#include <pthread.h>
+
+/*A trace file starts with TRACE_MAGIC and TRACE_VERSION followed by one
+  record per instruction reaching decodeFetched:
+    header        TRACE_* bits, the number of registers written above
+                  TRACE_WRITES_SHIFT
+    pc            if TRACE_JUMP: zigzag varint of the words from the
+                  instruction after the last one
+    flags         if TRACE_FLAGS: the byte NZCV
+    writes        a byte register then the zigzag varint of the difference
+                  with its last value, for every register written
+    memory        if TRACE_MEMORY: the zigzag varint of the difference with
+                  the last address then, if TRACE_STORE, the varint value
+  Everything starts at 0 but the last pc at -4, so a sequential instruction
+  writing no register is a single byte*/
+#define TRACE_START_PC -4
+#define TRACE_MAGIC "ARMTRACE"
+#define TRACE_MAGIC_LENGTH 8
+#define TRACE_VERSION 1
+#define TRACE_EXECUTED 0x01
+#define TRACE_JUMP 0x02
+#define TRACE_FLAGS 0x04
+#define TRACE_MEMORY 0x08
+#define TRACE_STORE 0x10
+#define TRACE_WRITES_SHIFT 5
+#define TRACE_MAX_WRITES 7 // an instruction writes 2 registers at most
+#define TRACE_REGS 15 // r0 to r14, the pc is in the record
+#define MAX_VARINT_LENGTH 5
+#define MAX_RECORD_LENGTH (2 + 3 * MAX_VARINT_LENGTH + \
+                           TRACE_MAX_WRITES * (1 + MAX_VARINT_LENGTH))
+#define TRACE_CHUNK_SIZE (1 << 16)
+#define TRACE_CHUNKS 64 // 4MB the writer can be behind
+
+/*-------------TypeDefinitions------------------*/
+typedef struct trace_chunk trace_chunk_t;
+
+/*-------------Defining the trace---------------*/
+struct trace_chunk {
+  uint8_t bytes[TRACE_CHUNK_SIZE];
+  int length;
+};
+
+struct trace {
+  FILE *file;
+  trace_chunk_t *chunks; //ring of TRACE_CHUNKS chunks
+  uint64_t head; //chunk being filled, written by the emulator
+  uint64_t tail; //next chunk to write, written by the writer thread
+  bool stop;
+  bool failed;
+  pthread_t writer;
+  pthread_mutex_t lock;
+  pthread_cond_t filled;
+  pthread_cond_t drained;
+  int regs[TRACE_REGS]; //the values as of the last record
+  int flags;
+  int pc;
+  int address;
+  bool memory; //a memory access of the instruction to record
+  bool store;
+  int memoryAddress;
+  int memoryValue;
+};
+
+/*------------------Prototypes-------------------*/
+trace_t *openTrace(const char *path);
+/*creates the trace file at path and starts its writer thread. Returns NULL
+  if the file can't be created*/
+
+bool closeTrace(trace_t *trace);
+/*writes the records left, stops the writer and frees the trace. Returns
+  false if any write failed*/
+
+void traceInstruction(trace_t *trace, proc_state_t *pState, bool executed);
+/*records the instruction pState has just run or skipped, with the registers
+  and flags it changed and its memory access*/
+
+static inline void traceMemoryAccess(trace_t *trace, int address, bool store,
+                                     int value) {
+  trace->memory = true;
+  trace->store = store;
+  trace->memoryAddress = address;
+  trace->memoryValue = value;
+}
+/*keeps the load or store of the instruction being run for its record*/
+
+static inline uint32_t zigzag(int32_t value) {
+  return ((uint32_t) value << 1) ^ (value < 0 ? UINT32_MAX : 0);
+}
+/*maps the small negative and positive values to small unsigned ones*/
+
+static inline int32_t unzigzag(uint32_t value) {
+  return (int32_t) ((value >> 1) ^ -(value & 1));
+}
+/*the inverse of zigzag*/
+
+#endif
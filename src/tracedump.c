@@ -0,0 +1,139 @@
+#include "trace.h"
+
+//--------------Reading--------------------------------------------------------
+static void truncated(void) {
+  fprintf(stderr, "%s\n", "Truncated trace");
+  exit(EXIT_FAILURE);
+}
+
+static int getByte(FILE *file) {
+  int byte = getc(file);
+  if(byte == EOF) {
+    truncated();
+  }
+  return byte;
+}
+
+static uint32_t getVarint(FILE *file) {
+  uint32_t value = 0;
+  for(int shift = 0; shift < 7 * MAX_VARINT_LENGTH; shift += 7) {
+    int byte = getByte(file);
+    value |= (uint32_t) (byte & 0x7F) << shift;
+    if(!(byte & 0x80)) {
+      return value;
+    }
+  }
+  truncated();
+  return value;
+}
+
+//--------------Printing-------------------------------------------------------
+/*prints the record as "pc run|skip [rN=value...] [NZCV=bits]
+  [load|store [address][=value]]", or as a line of csv*/
+static void printRecord(int header, int *written, int writes,
+                        trace_t *state, bool csv) {
+  int pc = state->pc;
+  int flags = state->flags;
+  bool executed = header & TRACE_EXECUTED;
+  bool memory = header & TRACE_MEMORY;
+  bool store = header & TRACE_STORE;
+  if(csv) {
+    printf("0x%.8x,%d,", pc, executed);
+    for(int i = 0; i < writes; i++) {
+      printf("%sr%d=0x%.8x", i ? ";" : "", written[i],
+             state->regs[written[i]]);
+    }
+    printf(",%d%d%d%d,", flags >> 3 & 1, flags >> 2 & 1, flags >> 1 & 1,
+           flags & 1);
+    if(memory) {
+      printf("%s,0x%.8x,", store ? "store" : "load", state->address);
+      if(store) {
+        printf("0x%.8x", state->memoryValue);
+      }
+    } else {
+      printf(",,");
+    }
+    printf("\n");
+    return;
+  }
+
+  printf("0x%.8x %s", pc, executed ? "run" : "skip");
+  for(int i = 0; i < writes; i++) {
+    printf(" r%d=0x%.8x", written[i], state->regs[written[i]]);
+  }
+  if(header & TRACE_FLAGS) {
+    printf(" NZCV=%d%d%d%d", flags >> 3 & 1, flags >> 2 & 1, flags >> 1 & 1,
+           flags & 1);
+  }
+  if(memory) {
+    printf(" %s [0x%.8x]", store ? "store" : "load", state->address);
+    if(store) {
+      printf("=0x%.8x", state->memoryValue);
+    }
+  }
+  printf("\n");
+}
+
+int main(int argc, char **argv) {
+  bool csv = argc == 3 && !strcmp(argv[1], "--csv");
+  if(argc != 2 && !csv) {
+    fprintf(stderr, "%s\n", "Usage: tracedump [--csv] trace");
+    return EXIT_FAILURE;
+  }
+  FILE *file = fopen(argv[argc - 1], "rb");
+  if(!file) {
+    perror(argv[argc - 1]);
+    return EXIT_FAILURE;
+  }
+  char magic[TRACE_MAGIC_LENGTH];
+  if(fread(magic, 1, TRACE_MAGIC_LENGTH, file) != TRACE_MAGIC_LENGTH ||
+     memcmp(magic, TRACE_MAGIC, TRACE_MAGIC_LENGTH) ||
+     getc(file) != TRACE_VERSION) {
+    fprintf(stderr, "%s is not a trace\n", argv[argc - 1]);
+    return EXIT_FAILURE;
+  }
+
+  //the values as of the last record, like when the trace was written
+  trace_t state;
+  memset(&state, 0, sizeof(state));
+  state.pc = TRACE_START_PC;
+  if(csv) {
+    printf("%s\n", "pc,executed,writes,nzcv,access,address,value");
+  }
+
+  int header;
+  while((header = getc(file)) != EOF) {
+    state.pc += 4;
+    if(header & TRACE_JUMP) {
+      state.pc += 4 * unzigzag(getVarint(file));
+    }
+    if(header & TRACE_FLAGS) {
+      state.flags = getByte(file);
+    }
+
+    int writes = header >> TRACE_WRITES_SHIFT;
+    int written[TRACE_MAX_WRITES];
+    for(int i = 0; i < writes; i++) {
+      int r = getByte(file);
+      if(r >= TRACE_REGS) {
+        fprintf(stderr, "%s\n", "Invalid register in the trace");
+        return EXIT_FAILURE;
+      }
+      state.regs[r] = (uint32_t) state.regs[r] +
+                      (uint32_t) unzigzag(getVarint(file));
+      written[i] = r;
+    }
+
+    if(header & TRACE_MEMORY) {
+      state.address = (uint32_t) state.address +
+                      (uint32_t) unzigzag(getVarint(file));
+      if(header & TRACE_STORE) {
+        state.memoryValue = getVarint(file);
+      }
+    }
+    printRecord(header, written, writes, &state, csv);
+  }
+
+  fclose(file);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,105 @@
+#include "workers.h"
+
+// -------------------FUNCTION DEFINITIONS-----------------------
+static void *work(void *arg) {
+  workerPool *p = arg;
+
+  pthread_mutex_lock(&p->lock);
+  while (true) {
+    while (!p->stop && p->next >= p->count) {
+      pthread_cond_wait(&p->start, &p->lock);
+    }
+
+    if (p->stop) {
+      break;
+    }
+
+    // take the next job of the batch
+    void *job = p->jobs + p->next * p->jobSize;
+    p->next++;
+    pthread_mutex_unlock(&p->lock);
+
+    p->function(job);
+
+    pthread_mutex_lock(&p->lock);
+    if (++p->done == p->count) {
+      pthread_cond_signal(&p->finished);
+    }
+  }
+  pthread_mutex_unlock(&p->lock);
+
+  return NULL;
+}
+
+bool constructWorkerPool(workerPool *p, int size) {
+  p->threads = malloc(size * sizeof(pthread_t));
+  p->size = 0;
+  p->function = NULL;
+  p->jobs = NULL;
+  p->jobSize = 0;
+  p->count = 0;
+  p->next = 0;
+  p->done = 0;
+  p->stop = false;
+
+  if (!p->threads) {
+    return false;
+  }
+
+  pthread_mutex_init(&p->lock, NULL);
+  pthread_cond_init(&p->start, NULL);
+  pthread_cond_init(&p->finished, NULL);
+
+  for (int i = 0; i < size; i++) {
+    if (pthread_create(&p->threads[i], NULL, work, p)) {
+      clearWorkerPool(p);
+      return false;
+    }
+    p->size++;
+  }
+
+  return true;
+}
+
+void runJobs(workerPool *p, jobFunction function, void *jobs, size_t jobSize,
+             int count) {
+  if (!count) {
+    return;
+  }
+
+  pthread_mutex_lock(&p->lock);
+  p->function = function;
+  p->jobs = jobs;
+  p->jobSize = jobSize;
+  p->next = 0;
+  p->done = 0;
+  p->count = count;
+  pthread_cond_broadcast(&p->start);
+
+  while (p->done < p->count) {
+    pthread_cond_wait(&p->finished, &p->lock);
+  }
+
+  // nothing left to hand out until the next batch
+  p->count = 0;
+  p->next = 0;
+  pthread_mutex_unlock(&p->lock);
+}
+
+void clearWorkerPool(workerPool *p) {
+  pthread_mutex_lock(&p->lock);
+  p->stop = true;
+  pthread_cond_broadcast(&p->start);
+  pthread_mutex_unlock(&p->lock);
+
+  for (int i = 0; i < p->size; i++) {
+    pthread_join(p->threads[i], NULL);
+  }
+
+  pthread_mutex_destroy(&p->lock);
+  pthread_cond_destroy(&p->start);
+  pthread_cond_destroy(&p->finished);
+  free(p->threads);
+  p->threads = NULL;
+  p->size = 0;
+}
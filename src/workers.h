@@ -0,0 +1,46 @@
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include "headers.h"
+#include <pthread.h>
+
+// -------------------------TYPES---------------------------------
+typedef struct workerPool workerPool;
+typedef void (*jobFunction)(void *job);
+
+// -------------------------STRUCTS-------------------------------
+/**
+* A fixed set of threads which run batches of jobs. A batch is an array of
+* count jobs of jobSize bytes each, every job is handed to function exactly
+* once. next is the next job to hand out and done the number of finished jobs
+**/
+struct workerPool {
+  pthread_t       *threads;
+  int             size;
+  pthread_mutex_t lock;
+  pthread_cond_t  start;
+  pthread_cond_t  finished;
+  jobFunction     function;
+  char            *jobs;
+  size_t          jobSize;
+  int             count;
+  int             next;
+  int             done;
+  bool            stop;
+};
+
+// -------------------FUNCTION DECLARATIONS-----------------------
+/**
+* Starts size worker threads
+* Returns false if the threads couldn't be created
+**/
+bool constructWorkerPool(workerPool *p, int size);
+
+/* Runs function on each of the count jobs and waits for all of them */
+void runJobs(workerPool *p, jobFunction function, void *jobs, size_t jobSize,
+             int count);
+
+/* Stops and joins all the worker threads */
+void clearWorkerPool(workerPool *p);
+
+#endif